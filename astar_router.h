@@ -0,0 +1,274 @@
+#pragma once
+
+#include "router.h"
+#include "geo.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Двунаправленный A*: прямой поиск от from и обратный от to идут по графу с
+// приведёнными весами. Потенциал вершины - полуразность нижних оценок времени
+// до to и от from по расстоянию на сфере между координатами вершин.
+// weight_per_meter должен быть таким, чтобы вес любого ребра был не меньше
+// расстояния между его концами, умноженного на weight_per_meter. Тогда
+// приведённые веса неотрицательны и путь получается кратчайшим
+template <typename Weight>
+class AStarRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    AStarRouter(const Graph& graph, std::vector<geo::Coordinates> vertex_coordinates, double weight_per_meter);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override {
+        NullSearchMonitor monitor;
+        return Search(from, to, monitor);
+    }
+
+    std::optional<RouteInfo> BuildMonitoredRoute(VertexId from, VertexId to, SearchMonitor& monitor) const override {
+        return Search(from, to, monitor);
+    }
+
+    // Суммарное число вершин, просмотренных обоими поисками во всех запросах
+    size_t GetSettledVertexCount() const {
+        return settled_vertex_count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    struct SearchSide {
+        std::vector<std::optional<Weight>> distances;
+        std::vector<std::optional<EdgeId>> prev_edges;
+        std::vector<char> settled;
+        std::vector<QueueItem> queue;
+    };
+
+    // Буферы переиспользуются всеми запросами одного потока; после запроса
+    // сбрасываются только вершины, до которых дошёл поиск
+    struct SearchBuffers {
+        SearchSide forward;
+        SearchSide backward;
+        std::vector<std::optional<Weight>> potentials;
+        std::vector<VertexId> touched_vertices;
+    };
+
+    // Если monitor прервал поиск, маршрута нет
+    template <typename Monitor>
+    std::optional<RouteInfo> Search(VertexId from, VertexId to, Monitor& monitor) const;
+
+    static SearchBuffers& GetSearchBuffers(size_t vertex_count);
+    static void ResetSearchBuffers(SearchBuffers& buffers);
+
+    Weight GetPotential(VertexId vertex, VertexId from, VertexId to, SearchBuffers& buffers) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    std::vector<geo::Coordinates> vertex_coordinates_;
+    double weight_per_meter_;
+    // Обратные рёбра в CSR: для каждой вершины входящие рёбра, их начала и веса
+    std::vector<size_t> in_offsets_;
+    std::vector<EdgeId> in_edges_;
+    std::vector<VertexId> in_sources_;
+    std::vector<Weight> in_weights_;
+    mutable std::atomic<size_t> settled_vertex_count_{ 0 };
+};
+
+template <typename Weight>
+AStarRouter<Weight>::AStarRouter(const Graph& graph, std::vector<geo::Coordinates> vertex_coordinates,
+    double weight_per_meter)
+    : graph_(graph)
+    , vertex_coordinates_(std::move(vertex_coordinates))
+    , weight_per_meter_(weight_per_meter)
+{
+    if (!graph.IsFrozen()) {
+        throw std::invalid_argument("Graph should be frozen");
+    }
+    if (vertex_coordinates_.size() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Vertex coordinates don't match the graph");
+    }
+    const size_t vertex_count = graph.GetVertexCount();
+    in_offsets_.assign(vertex_count + 1, 0);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        ++in_offsets_[edge.to + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        in_offsets_[vertex + 1] += in_offsets_[vertex];
+    }
+    in_edges_.resize(graph.GetEdgeCount());
+    in_sources_.resize(graph.GetEdgeCount());
+    in_weights_.resize(graph.GetEdgeCount());
+    std::vector<size_t> next_slots(in_offsets_.begin(), in_offsets_.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        const size_t slot = next_slots[edge.to]++;
+        in_edges_[slot] = edge_id;
+        in_sources_[slot] = edge.from;
+        in_weights_[slot] = edge.weight;
+    }
+}
+
+template <typename Weight>
+typename AStarRouter<Weight>::SearchBuffers& AStarRouter<Weight>::GetSearchBuffers(size_t vertex_count) {
+    static thread_local SearchBuffers buffers;
+    if (buffers.potentials.size() < vertex_count) {
+        for (SearchSide* side : { &buffers.forward, &buffers.backward }) {
+            side->distances.resize(vertex_count);
+            side->prev_edges.resize(vertex_count);
+            side->settled.resize(vertex_count, false);
+        }
+        buffers.potentials.resize(vertex_count);
+    }
+    return buffers;
+}
+
+template <typename Weight>
+void AStarRouter<Weight>::ResetSearchBuffers(SearchBuffers& buffers) {
+    for (const VertexId vertex : buffers.touched_vertices) {
+        for (SearchSide* side : { &buffers.forward, &buffers.backward }) {
+            side->distances[vertex].reset();
+            side->prev_edges[vertex].reset();
+            side->settled[vertex] = false;
+        }
+        buffers.potentials[vertex].reset();
+    }
+    buffers.touched_vertices.clear();
+    buffers.forward.queue.clear();
+    buffers.backward.queue.clear();
+}
+
+template <typename Weight>
+Weight AStarRouter<Weight>::GetPotential(VertexId vertex, VertexId from, VertexId to,
+    SearchBuffers& buffers) const {
+    auto& potential = buffers.potentials[vertex];
+    if (!potential) {
+        const geo::Coordinates& coordinates = vertex_coordinates_[vertex];
+        const double to_target = geo::ComputeDistance(coordinates, vertex_coordinates_[to]);
+        const double from_source = geo::ComputeDistance(vertex_coordinates_[from], coordinates);
+        potential = static_cast<Weight>((to_target - from_source) * weight_per_meter_ / 2);
+        buffers.touched_vertices.push_back(vertex);
+    }
+    return *potential;
+}
+
+template <typename Weight>
+template <typename Monitor>
+std::optional<typename AStarRouter<Weight>::RouteInfo> AStarRouter<Weight>::Search(VertexId from, VertexId to,
+    Monitor& monitor) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from == to) {
+        return RouteInfo{ ZERO_WEIGHT, {} };
+    }
+    SearchBuffers& buffers = GetSearchBuffers(graph_.GetVertexCount());
+    SearchSide& forward = buffers.forward;
+    SearchSide& backward = buffers.backward;
+    const auto queue_compare = std::greater<QueueItem>{};
+
+    // Ключ прямого поиска - расстояние плюс потенциал, обратного - минус
+    // потенциал, поэтому сумма ключей на одной вершине равна длине пути
+    forward.distances[from] = ZERO_WEIGHT;
+    forward.queue.push_back({ GetPotential(from, from, to, buffers), from });
+    backward.distances[to] = ZERO_WEIGHT;
+    backward.queue.push_back({ -GetPotential(to, from, to, buffers), to });
+    monitor.OnPush();
+    monitor.OnPush();
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    size_t settled_count = 0;
+
+    while (!forward.queue.empty() && !backward.queue.empty()) {
+        if (best_weight && !(forward.queue.front().first + backward.queue.front().first < *best_weight)) {
+            break;
+        }
+        const bool is_forward = !(backward.queue.front().first < forward.queue.front().first);
+        SearchSide& side = is_forward ? forward : backward;
+        const SearchSide& other_side = is_forward ? backward : forward;
+
+        std::pop_heap(side.queue.begin(), side.queue.end(), queue_compare);
+        const VertexId vertex = side.queue.back().second;
+        side.queue.pop_back();
+        monitor.OnPop();
+        if (side.settled[vertex]) {
+            continue;
+        }
+        side.settled[vertex] = true;
+        ++settled_count;
+        monitor.OnSettle();
+        if (monitor.IsExpired()) {
+            break;
+        }
+        const Weight weight = *side.distances[vertex];
+
+        const auto relax = [&](EdgeId edge_id, VertexId next, Weight edge_weight) {
+            const Weight candidate_weight = weight + edge_weight;
+            monitor.OnRelax();
+            auto& distance = side.distances[next];
+            if (!distance || candidate_weight < *distance) {
+                distance = candidate_weight;
+                side.prev_edges[next] = edge_id;
+                const Weight potential = GetPotential(next, from, to, buffers);
+                side.queue.push_back({ is_forward ? candidate_weight + potential : candidate_weight - potential, next });
+                std::push_heap(side.queue.begin(), side.queue.end(), queue_compare);
+                monitor.OnPush();
+            }
+            if (other_side.distances[next]) {
+                const Weight route_weight = *distance + *other_side.distances[next];
+                if (!best_weight || route_weight < *best_weight) {
+                    best_weight = route_weight;
+                    meeting_vertex = next;
+                }
+            }
+        };
+
+        if (is_forward) {
+            for (const auto edge : graph_.GetOutgoingEdges(vertex)) {
+                relax(edge.id, edge.to, edge.weight);
+            }
+        } else {
+            for (size_t i = in_offsets_[vertex]; i < in_offsets_[vertex + 1]; ++i) {
+                relax(in_edges_[i], in_sources_[i], in_weights_[i]);
+            }
+        }
+    }
+    settled_vertex_count_.fetch_add(settled_count, std::memory_order_relaxed);
+
+    std::optional<RouteInfo> route;
+    if (best_weight && !monitor.IsExpired()) {
+        std::vector<EdgeId> edges;
+        for (std::optional<EdgeId> edge_id = forward.prev_edges[meeting_vertex];
+            edge_id;
+            edge_id = forward.prev_edges[graph_.GetEdge(*edge_id).from])
+        {
+            edges.push_back(*edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+        for (std::optional<EdgeId> edge_id = backward.prev_edges[meeting_vertex];
+            edge_id;
+            edge_id = backward.prev_edges[graph_.GetEdge(*edge_id).to])
+        {
+            edges.push_back(*edge_id);
+        }
+        route = RouteInfo{ *best_weight, std::move(edges) };
+    }
+
+    ResetSearchBuffers(buffers);
+    return route;
+}
+
+}  // namespace graph
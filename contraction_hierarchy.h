@@ -0,0 +1,490 @@
+#pragma once
+
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Иерархия сжатия: вершины сжимаются по очереди, а пути через сжатую вершину
+// заменяются шорткатами. Запрос - двунаправленный поиск только вверх по рангам,
+// шорткаты затем раскрываются обратно в рёбра исходного графа
+template <typename Weight>
+class ContractionHierarchyRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    // Первые GetEdgeCount() рёбер иерархии совпадают с рёбрами графа,
+    // у шорткатов original_edge == NO_EDGE, а половины ссылаются на рёбра иерархии
+    struct HierarchyEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId original_edge;
+        EdgeId first_half;
+        EdgeId second_half;
+    };
+
+    struct Hierarchy {
+        std::vector<size_t> ranks;
+        std::vector<HierarchyEdge> edges;
+    };
+
+    explicit ContractionHierarchyRouter(const Graph& graph);
+    ContractionHierarchyRouter(const Graph& graph, Hierarchy hierarchy);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    const Hierarchy& GetHierarchy() const {
+        return hierarchy_;
+    }
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Priority = long long;
+
+    static constexpr size_t WITNESS_SEARCH_SETTLED_LIMIT = 100;
+
+    struct Shortcut {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId first_half;
+        EdgeId second_half;
+    };
+
+    struct ContractionState {
+        std::vector<std::vector<EdgeId>> out_edges;
+        std::vector<std::vector<EdgeId>> in_edges;
+        std::vector<Priority> contracted_neighbors;
+
+        std::vector<std::optional<Weight>> witness_distances;
+        std::vector<VertexId> witness_touched;
+        std::vector<QueueItem> witness_queue;
+    };
+
+    struct SearchSide {
+        std::vector<std::optional<Weight>> distances;
+        std::vector<EdgeId> parent_edges;
+        std::vector<VertexId> touched_vertices;
+        std::vector<QueueItem> queue;
+    };
+
+    struct SearchBuffers {
+        SearchSide forward;
+        SearchSide backward;
+    };
+
+    // В списках смежности остаются только рёбра между ещё не сжатыми вершинами,
+    // по одному самому лёгкому на пару вершин
+    bool InsertLiveEdge(ContractionState& state, EdgeId edge_id) const;
+    static void EraseLiveEdge(std::vector<EdgeId>& edge_ids, EdgeId edge_id);
+
+    void RunWitnessSearch(ContractionState& state, VertexId source, VertexId excluded, Weight max_weight) const;
+    std::vector<Shortcut> FindShortcuts(ContractionState& state, VertexId vertex) const;
+    Priority ComputePriority(const ContractionState& state, VertexId vertex, size_t shortcut_count) const;
+    void Contract();
+    void BuildSearchGraph();
+
+    static SearchBuffers& GetSearchBuffers(size_t vertex_count);
+    static void ResetSearchSide(SearchSide& side);
+    void AppendUnpackedEdges(EdgeId hierarchy_edge, std::vector<EdgeId>& edges) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    Hierarchy hierarchy_;
+
+    // Рёбра поиска вверх в формате CSR: upward_out_ - из вершины в более
+    // старшие, upward_in_ - в вершину из более старших (для обратного поиска)
+    std::vector<size_t> upward_out_offsets_;
+    std::vector<EdgeId> upward_out_;
+    std::vector<size_t> upward_in_offsets_;
+    std::vector<EdgeId> upward_in_;
+};
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph)
+    : graph_(graph)
+{
+    hierarchy_.edges.reserve(graph.GetEdgeCount());
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        hierarchy_.edges.push_back({ edge.from, edge.to, edge.weight, edge_id, NO_EDGE, NO_EDGE });
+    }
+    Contract();
+    BuildSearchGraph();
+}
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph, Hierarchy hierarchy)
+    : graph_(graph)
+    , hierarchy_(std::move(hierarchy))
+{
+    if (hierarchy_.ranks.size() != graph.GetVertexCount() || hierarchy_.edges.size() < graph.GetEdgeCount()) {
+        throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+    }
+    BuildSearchGraph();
+}
+
+template <typename Weight>
+bool ContractionHierarchyRouter<Weight>::InsertLiveEdge(ContractionState& state, EdgeId edge_id) const {
+    const auto& edge = hierarchy_.edges[edge_id];
+    if (edge.from == edge.to) {
+        return false;
+    }
+    auto& out_edges = state.out_edges[edge.from];
+    const auto parallel = std::find_if(out_edges.begin(), out_edges.end(), [this, &edge](EdgeId other_id) {
+        return hierarchy_.edges[other_id].to == edge.to;
+    });
+    if (parallel != out_edges.end()) {
+        if (!(edge.weight < hierarchy_.edges[*parallel].weight)) {
+            return false;
+        }
+        EraseLiveEdge(state.in_edges[edge.to], *parallel);
+        *parallel = edge_id;
+    } else {
+        out_edges.push_back(edge_id);
+    }
+    state.in_edges[edge.to].push_back(edge_id);
+    return true;
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::EraseLiveEdge(std::vector<EdgeId>& edge_ids, EdgeId edge_id) {
+    edge_ids.erase(std::find(edge_ids.begin(), edge_ids.end(), edge_id));
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::RunWitnessSearch(ContractionState& state, VertexId source,
+    VertexId excluded, Weight max_weight) const {
+    auto& distances = state.witness_distances;
+    auto& queue = state.witness_queue;
+    const auto queue_compare = std::greater<QueueItem>{};
+
+    distances[source] = ZERO_WEIGHT;
+    state.witness_touched.push_back(source);
+    queue.push_back({ ZERO_WEIGHT, source });
+
+    size_t settled_count = 0;
+    while (!queue.empty() && settled_count < WITNESS_SEARCH_SETTLED_LIMIT) {
+        std::pop_heap(queue.begin(), queue.end(), queue_compare);
+        const auto [weight, vertex] = queue.back();
+        queue.pop_back();
+
+        if (*distances[vertex] < weight) {
+            continue;
+        }
+        if (max_weight < weight) {
+            break;
+        }
+        ++settled_count;
+        for (const EdgeId edge_id : state.out_edges[vertex]) {
+            const auto& edge = hierarchy_.edges[edge_id];
+            if (edge.to == excluded) {
+                continue;
+            }
+            const Weight candidate_weight = weight + edge.weight;
+            auto& distance = distances[edge.to];
+            if (!distance || candidate_weight < *distance) {
+                if (!distance) {
+                    state.witness_touched.push_back(edge.to);
+                }
+                distance = candidate_weight;
+                queue.push_back({ candidate_weight, edge.to });
+                std::push_heap(queue.begin(), queue.end(), queue_compare);
+            }
+        }
+    }
+    queue.clear();
+}
+
+template <typename Weight>
+std::vector<typename ContractionHierarchyRouter<Weight>::Shortcut>
+ContractionHierarchyRouter<Weight>::FindShortcuts(ContractionState& state, VertexId vertex) const {
+    std::vector<Shortcut> shortcuts;
+    const auto& in_edges = state.in_edges[vertex];
+    const auto& out_edges = state.out_edges[vertex];
+    if (in_edges.empty() || out_edges.empty()) {
+        return shortcuts;
+    }
+
+    Weight max_out_weight = ZERO_WEIGHT;
+    for (const EdgeId out_edge : out_edges) {
+        max_out_weight = std::max(max_out_weight, hierarchy_.edges[out_edge].weight);
+    }
+
+    for (const EdgeId in_edge : in_edges) {
+        const VertexId from = hierarchy_.edges[in_edge].from;
+        const Weight in_weight = hierarchy_.edges[in_edge].weight;
+        RunWitnessSearch(state, from, vertex, in_weight + max_out_weight);
+        for (const EdgeId out_edge : out_edges) {
+            const VertexId to = hierarchy_.edges[out_edge].to;
+            if (to == from) {
+                continue;
+            }
+            const Weight via_weight = in_weight + hierarchy_.edges[out_edge].weight;
+            const auto& witness_distance = state.witness_distances[to];
+            if (!witness_distance || via_weight < *witness_distance) {
+                shortcuts.push_back({ from, to, via_weight, in_edge, out_edge });
+            }
+        }
+        for (const VertexId touched : state.witness_touched) {
+            state.witness_distances[touched].reset();
+        }
+        state.witness_touched.clear();
+    }
+    return shortcuts;
+}
+
+template <typename Weight>
+typename ContractionHierarchyRouter<Weight>::Priority ContractionHierarchyRouter<Weight>::ComputePriority(
+    const ContractionState& state, VertexId vertex, size_t shortcut_count) const {
+    const Priority removed_edges = static_cast<Priority>(state.in_edges[vertex].size() + state.out_edges[vertex].size());
+    return static_cast<Priority>(shortcut_count) - removed_edges + state.contracted_neighbors[vertex];
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::Contract() {
+    const size_t vertex_count = graph_.GetVertexCount();
+
+    ContractionState state;
+    state.out_edges.resize(vertex_count);
+    state.in_edges.resize(vertex_count);
+    state.contracted_neighbors.assign(vertex_count, 0);
+    state.witness_distances.resize(vertex_count);
+    for (EdgeId edge_id = 0; edge_id < hierarchy_.edges.size(); ++edge_id) {
+        InsertLiveEdge(state, edge_id);
+    }
+
+    using PriorityItem = std::pair<Priority, VertexId>;
+    std::vector<PriorityItem> queue;
+    queue.reserve(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.push_back({ ComputePriority(state, vertex, FindShortcuts(state, vertex).size()), vertex });
+    }
+    const auto queue_compare = std::greater<PriorityItem>{};
+    std::make_heap(queue.begin(), queue.end(), queue_compare);
+
+    hierarchy_.ranks.assign(vertex_count, 0);
+    size_t rank = 0;
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), queue_compare);
+        const VertexId vertex = queue.back().second;
+        queue.pop_back();
+
+        // Приоритеты пересчитываются лениво: если вершина подешевела не так,
+        // как думали, она возвращается в очередь
+        const auto shortcuts = FindShortcuts(state, vertex);
+        const Priority priority = ComputePriority(state, vertex, shortcuts.size());
+        if (!queue.empty() && queue.front().first < priority) {
+            queue.push_back({ priority, vertex });
+            std::push_heap(queue.begin(), queue.end(), queue_compare);
+            continue;
+        }
+
+        hierarchy_.ranks[vertex] = rank++;
+        for (const EdgeId edge_id : state.out_edges[vertex]) {
+            const VertexId to = hierarchy_.edges[edge_id].to;
+            EraseLiveEdge(state.in_edges[to], edge_id);
+            ++state.contracted_neighbors[to];
+        }
+        for (const EdgeId edge_id : state.in_edges[vertex]) {
+            const VertexId from = hierarchy_.edges[edge_id].from;
+            EraseLiveEdge(state.out_edges[from], edge_id);
+            ++state.contracted_neighbors[from];
+        }
+        state.out_edges[vertex] = {};
+        state.in_edges[vertex] = {};
+
+        for (const Shortcut& shortcut : shortcuts) {
+            hierarchy_.edges.push_back({ shortcut.from, shortcut.to, shortcut.weight,
+                                         NO_EDGE, shortcut.first_half, shortcut.second_half });
+            if (!InsertLiveEdge(state, hierarchy_.edges.size() - 1)) {
+                hierarchy_.edges.pop_back();
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::BuildSearchGraph() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const auto& ranks = hierarchy_.ranks;
+
+    upward_out_offsets_.assign(vertex_count + 1, 0);
+    upward_in_offsets_.assign(vertex_count + 1, 0);
+    for (const auto& edge : hierarchy_.edges) {
+        if (edge.from >= vertex_count || edge.to >= vertex_count) {
+            throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+        }
+        if (ranks[edge.from] < ranks[edge.to]) {
+            ++upward_out_offsets_[edge.from + 1];
+        } else if (ranks[edge.to] < ranks[edge.from]) {
+            ++upward_in_offsets_[edge.to + 1];
+        }
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        upward_out_offsets_[vertex + 1] += upward_out_offsets_[vertex];
+        upward_in_offsets_[vertex + 1] += upward_in_offsets_[vertex];
+    }
+
+    upward_out_.resize(upward_out_offsets_.back());
+    upward_in_.resize(upward_in_offsets_.back());
+    std::vector<size_t> out_positions(upward_out_offsets_.begin(), upward_out_offsets_.end() - 1);
+    std::vector<size_t> in_positions(upward_in_offsets_.begin(), upward_in_offsets_.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < hierarchy_.edges.size(); ++edge_id) {
+        const auto& edge = hierarchy_.edges[edge_id];
+        if (ranks[edge.from] < ranks[edge.to]) {
+            upward_out_[out_positions[edge.from]++] = edge_id;
+        } else if (ranks[edge.to] < ranks[edge.from]) {
+            upward_in_[in_positions[edge.to]++] = edge_id;
+        }
+    }
+}
+
+template <typename Weight>
+typename ContractionHierarchyRouter<Weight>::SearchBuffers&
+ContractionHierarchyRouter<Weight>::GetSearchBuffers(size_t vertex_count) {
+    static thread_local SearchBuffers buffers;
+    for (SearchSide* side : { &buffers.forward, &buffers.backward }) {
+        if (side->distances.size() < vertex_count) {
+            side->distances.resize(vertex_count);
+            side->parent_edges.resize(vertex_count, NO_EDGE);
+        }
+    }
+    return buffers;
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::ResetSearchSide(SearchSide& side) {
+    for (const VertexId vertex : side.touched_vertices) {
+        side.distances[vertex].reset();
+        side.parent_edges[vertex] = NO_EDGE;
+    }
+    side.touched_vertices.clear();
+    side.queue.clear();
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::AppendUnpackedEdges(EdgeId hierarchy_edge,
+    std::vector<EdgeId>& edges) const {
+    std::vector<EdgeId> stack{ hierarchy_edge };
+    while (!stack.empty()) {
+        const auto& edge = hierarchy_.edges[stack.back()];
+        stack.pop_back();
+        if (edge.original_edge != NO_EDGE) {
+            edges.push_back(edge.original_edge);
+        } else {
+            stack.push_back(edge.second_half);
+            stack.push_back(edge.first_half);
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from == to) {
+        return RouteInfo{ ZERO_WEIGHT, {} };
+    }
+
+    SearchBuffers& buffers = GetSearchBuffers(vertex_count);
+    const auto queue_compare = std::greater<QueueItem>{};
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+
+    for (auto [side, vertex] : { std::pair{ &buffers.forward, from }, std::pair{ &buffers.backward, to } }) {
+        side->distances[vertex] = ZERO_WEIGHT;
+        side->touched_vertices.push_back(vertex);
+        side->queue.push_back({ ZERO_WEIGHT, vertex });
+    }
+
+    bool forward_turn = true;
+    while (!buffers.forward.queue.empty() || !buffers.backward.queue.empty()) {
+        if (buffers.forward.queue.empty() || buffers.backward.queue.empty()) {
+            forward_turn = !buffers.forward.queue.empty();
+        }
+        SearchSide& side = forward_turn ? buffers.forward : buffers.backward;
+        const SearchSide& other_side = forward_turn ? buffers.backward : buffers.forward;
+        const auto& offsets = forward_turn ? upward_out_offsets_ : upward_in_offsets_;
+        const auto& upward_edges = forward_turn ? upward_out_ : upward_in_;
+
+        std::pop_heap(side.queue.begin(), side.queue.end(), queue_compare);
+        const auto [weight, vertex] = side.queue.back();
+        side.queue.pop_back();
+        forward_turn = !forward_turn;
+
+        if (*side.distances[vertex] < weight) {
+            continue;
+        }
+        if (best_weight && !(weight < *best_weight)) {
+            side.queue.clear();
+            continue;
+        }
+        if (const auto& other_distance = other_side.distances[vertex]) {
+            const Weight candidate_weight = weight + *other_distance;
+            if (!best_weight || candidate_weight < *best_weight) {
+                best_weight = candidate_weight;
+                meeting_vertex = vertex;
+            }
+        }
+        for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const EdgeId edge_id = upward_edges[i];
+            const auto& edge = hierarchy_.edges[edge_id];
+            const VertexId next = &side == &buffers.forward ? edge.to : edge.from;
+            const Weight candidate_weight = weight + edge.weight;
+            auto& distance = side.distances[next];
+            if (!distance || candidate_weight < *distance) {
+                if (!distance) {
+                    side.touched_vertices.push_back(next);
+                }
+                distance = candidate_weight;
+                side.parent_edges[next] = edge_id;
+                side.queue.push_back({ candidate_weight, next });
+                std::push_heap(side.queue.begin(), side.queue.end(), queue_compare);
+            }
+        }
+    }
+
+    std::optional<RouteInfo> route;
+    if (best_weight) {
+        std::vector<EdgeId> forward_edges;
+        for (VertexId vertex = meeting_vertex; buffers.forward.parent_edges[vertex] != NO_EDGE;
+            vertex = hierarchy_.edges[buffers.forward.parent_edges[vertex]].from) {
+            forward_edges.push_back(buffers.forward.parent_edges[vertex]);
+        }
+        std::vector<EdgeId> edges;
+        for (auto it = forward_edges.rbegin(); it != forward_edges.rend(); ++it) {
+            AppendUnpackedEdges(*it, edges);
+        }
+        for (VertexId vertex = meeting_vertex; buffers.backward.parent_edges[vertex] != NO_EDGE;
+            vertex = hierarchy_.edges[buffers.backward.parent_edges[vertex]].to) {
+            AppendUnpackedEdges(buffers.backward.parent_edges[vertex], edges);
+        }
+        route = RouteInfo{ *best_weight, std::move(edges) };
+    }
+
+    ResetSearchSide(buffers.forward);
+    ResetSearchSide(buffers.backward);
+    return route;
+}
+
+}  // namespace graph
@@ -0,0 +1,378 @@
+#pragma once
+
+#include "router.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск кратчайшего пути между парой вершин по запросу: O(V + E) памяти,
+// без предварительного расчёта таблицы всех пар. Граф должен быть заморожен:
+// поиск идёт по его плотным массивам концов и весов рёбер
+template <typename Weight>
+class DijkstraRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    std::optional<RouteInfo> BuildMonitoredRoute(VertexId from, VertexId to, SearchMonitor& monitor) const override;
+
+    // Поиск с весами рёбер edge_weight(edge_id) вместо весов графа: веса
+    // можно менять от запроса к запросу, ничего не перестраивая
+    template <typename EdgeWeight>
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, EdgeWeight edge_weight) const {
+        NullSearchMonitor monitor;
+        return BuildRoute(from, to, edge_weight, monitor);
+    }
+
+    template <typename EdgeWeight, typename Monitor>
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, EdgeWeight edge_weight, Monitor& monitor) const;
+
+    // Все вершины на расстоянии не больше max_weight от from с расстояниями до
+    // них, по возрастанию расстояния. Поиск не выходит за max_weight
+    std::vector<std::pair<VertexId, Weight>> BuildReachable(VertexId from, Weight max_weight) const;
+
+    // Расстояния от from до каждой из targets одним поиском, который
+    // останавливается, когда просмотрены все цели
+    std::vector<std::optional<Weight>> BuildDistances(VertexId from, const std::vector<VertexId>& targets) const;
+
+    // Маршруты от from до каждой из targets одним поиском. Маршруты те же,
+    // что у BuildRoute по отдельности: до цели поиск идёт в том же порядке
+    std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& targets) const;
+
+    // Суммарное число вершин, просмотренных во всех запросах
+    size_t GetSettledVertexCount() const {
+        return settled_vertex_count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    // Буферы переиспользуются всеми запросами одного потока; после запроса
+    // сбрасываются только вершины, до которых дошёл поиск
+    struct SearchBuffers {
+        std::vector<std::optional<Weight>> distances;
+        std::vector<std::optional<EdgeId>> prev_edges;
+        std::vector<VertexId> touched_vertices;
+        std::vector<QueueItem> queue;
+        std::vector<char> is_target;
+    };
+
+    static SearchBuffers& GetSearchBuffers(size_t vertex_count) {
+        static thread_local SearchBuffers buffers;
+        if (buffers.distances.size() < vertex_count) {
+            buffers.distances.resize(vertex_count);
+            buffers.prev_edges.resize(vertex_count);
+            buffers.is_target.resize(vertex_count, false);
+        }
+        return buffers;
+    }
+
+    // Отмечает цели в is_target, возвращает число разных целей
+    size_t MarkTargets(SearchBuffers& buffers, const std::vector<VertexId>& targets) const;
+
+    // Поиск от from, пока не просмотрены все отмеченные цели; просмотренные
+    // цели снимаются с отметки
+    void SearchTargets(SearchBuffers& buffers, VertexId from, size_t target_count) const;
+
+    static void ResetSearchBuffers(SearchBuffers& buffers) {
+        for (const VertexId vertex : buffers.touched_vertices) {
+            buffers.distances[vertex].reset();
+            buffers.prev_edges[vertex].reset();
+        }
+        buffers.touched_vertices.clear();
+        buffers.queue.clear();
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    mutable std::atomic<size_t> settled_vertex_count_{ 0 };
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+{
+    if (!graph.IsFrozen()) {
+        throw std::invalid_argument("Graph should be frozen");
+    }
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+    VertexId to) const {
+    return BuildRoute(from, to, [](EdgeId, Weight graph_weight) {
+        return graph_weight;
+    });
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildMonitoredRoute(VertexId from,
+    VertexId to, SearchMonitor& monitor) const {
+    return BuildRoute(from, to, [](EdgeId, Weight graph_weight) {
+        return graph_weight;
+    }, monitor);
+}
+
+// edge_weight получает id ребра и его вес в графе. Если monitor прервал
+// поиск, маршрута нет
+template <typename Weight>
+template <typename EdgeWeight, typename Monitor>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+    VertexId to, EdgeWeight edge_weight, Monitor& monitor) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    SearchBuffers& buffers = GetSearchBuffers(graph_.GetVertexCount());
+    auto& distances = buffers.distances;
+    auto& prev_edges = buffers.prev_edges;
+    auto& queue = buffers.queue;
+    const auto queue_compare = std::greater<QueueItem>{};
+
+    distances[from] = ZERO_WEIGHT;
+    buffers.touched_vertices.push_back(from);
+    queue.push_back({ ZERO_WEIGHT, from });
+    monitor.OnPush();
+    size_t settled_count = 0;
+
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), queue_compare);
+        const auto [weight, vertex] = queue.back();
+        queue.pop_back();
+        monitor.OnPop();
+
+        if (*distances[vertex] < weight) {
+            continue;
+        }
+        ++settled_count;
+        monitor.OnSettle();
+        if (vertex == to || monitor.IsExpired()) {
+            break;
+        }
+        for (const auto edge : graph_.GetOutgoingEdges(vertex)) {
+            const Weight candidate_weight = weight + edge_weight(edge.id, edge.weight);
+            monitor.OnRelax();
+            auto& distance = distances[edge.to];
+            if (!distance || candidate_weight < *distance) {
+                if (!distance) {
+                    buffers.touched_vertices.push_back(edge.to);
+                }
+                distance = candidate_weight;
+                prev_edges[edge.to] = edge.id;
+                queue.push_back({ candidate_weight, edge.to });
+                std::push_heap(queue.begin(), queue.end(), queue_compare);
+                monitor.OnPush();
+            }
+        }
+    }
+
+    settled_vertex_count_.fetch_add(settled_count, std::memory_order_relaxed);
+
+    std::optional<RouteInfo> route;
+    if (distances[to] && !monitor.IsExpired()) {
+        std::vector<EdgeId> edges;
+        for (std::optional<EdgeId> edge_id = prev_edges[to];
+            edge_id;
+            edge_id = prev_edges[graph_.GetEdge(*edge_id).from])
+        {
+            edges.push_back(*edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+        route = RouteInfo{ *distances[to], std::move(edges) };
+    }
+
+    ResetSearchBuffers(buffers);
+    return route;
+}
+
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight>::BuildReachable(VertexId from,
+    Weight max_weight) const {
+    if (from >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    SearchBuffers& buffers = GetSearchBuffers(graph_.GetVertexCount());
+    auto& distances = buffers.distances;
+    auto& queue = buffers.queue;
+    const auto queue_compare = std::greater<QueueItem>{};
+
+    std::vector<std::pair<VertexId, Weight>> reachable;
+    if (max_weight < ZERO_WEIGHT) {
+        return reachable;
+    }
+    distances[from] = ZERO_WEIGHT;
+    buffers.touched_vertices.push_back(from);
+    queue.push_back({ ZERO_WEIGHT, from });
+
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), queue_compare);
+        const auto [weight, vertex] = queue.back();
+        queue.pop_back();
+
+        if (*distances[vertex] < weight) {
+            continue;
+        }
+        reachable.push_back({ vertex, weight });
+        for (const auto edge : graph_.GetOutgoingEdges(vertex)) {
+            const Weight candidate_weight = weight + edge.weight;
+            if (max_weight < candidate_weight) {
+                continue;
+            }
+            auto& distance = distances[edge.to];
+            if (!distance || candidate_weight < *distance) {
+                if (!distance) {
+                    buffers.touched_vertices.push_back(edge.to);
+                }
+                distance = candidate_weight;
+                queue.push_back({ candidate_weight, edge.to });
+                std::push_heap(queue.begin(), queue.end(), queue_compare);
+            }
+        }
+    }
+
+    settled_vertex_count_.fetch_add(reachable.size(), std::memory_order_relaxed);
+    ResetSearchBuffers(buffers);
+    return reachable;
+}
+
+template <typename Weight>
+size_t DijkstraRouter<Weight>::MarkTargets(SearchBuffers& buffers, const std::vector<VertexId>& targets) const {
+    for (const VertexId target : targets) {
+        if (target >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+    size_t target_count = 0;
+    for (const VertexId target : targets) {
+        if (!buffers.is_target[target]) {
+            buffers.is_target[target] = true;
+            ++target_count;
+        }
+    }
+    return target_count;
+}
+
+template <typename Weight>
+void DijkstraRouter<Weight>::SearchTargets(SearchBuffers& buffers, VertexId from, size_t target_count) const {
+    auto& distances = buffers.distances;
+    auto& prev_edges = buffers.prev_edges;
+    auto& queue = buffers.queue;
+    auto& is_target = buffers.is_target;
+    const auto queue_compare = std::greater<QueueItem>{};
+
+    distances[from] = ZERO_WEIGHT;
+    buffers.touched_vertices.push_back(from);
+    queue.push_back({ ZERO_WEIGHT, from });
+    size_t settled_count = 0;
+
+    while (!queue.empty() && target_count > 0) {
+        std::pop_heap(queue.begin(), queue.end(), queue_compare);
+        const auto [weight, vertex] = queue.back();
+        queue.pop_back();
+
+        if (*distances[vertex] < weight) {
+            continue;
+        }
+        ++settled_count;
+        if (is_target[vertex]) {
+            is_target[vertex] = false;
+            --target_count;
+            if (target_count == 0) {
+                break;
+            }
+        }
+        for (const auto edge : graph_.GetOutgoingEdges(vertex)) {
+            const Weight candidate_weight = weight + edge.weight;
+            auto& distance = distances[edge.to];
+            if (!distance || candidate_weight < *distance) {
+                if (!distance) {
+                    buffers.touched_vertices.push_back(edge.to);
+                }
+                distance = candidate_weight;
+                prev_edges[edge.to] = edge.id;
+                queue.push_back({ candidate_weight, edge.to });
+                std::push_heap(queue.begin(), queue.end(), queue_compare);
+            }
+        }
+    }
+    settled_vertex_count_.fetch_add(settled_count, std::memory_order_relaxed);
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>> DijkstraRouter<Weight>::BuildDistances(VertexId from,
+    const std::vector<VertexId>& targets) const {
+    if (from >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    SearchBuffers& buffers = GetSearchBuffers(graph_.GetVertexCount());
+    auto& is_target = buffers.is_target;
+    SearchTargets(buffers, from, MarkTargets(buffers, targets));
+
+    // Цели, до которых поиск не дошёл, ещё помечены: до них пути нет
+    std::vector<std::optional<Weight>> result;
+    result.reserve(targets.size());
+    for (const VertexId target : targets) {
+        result.push_back(is_target[target] ? std::nullopt : buffers.distances[target]);
+    }
+    for (const VertexId target : targets) {
+        is_target[target] = false;
+    }
+
+    ResetSearchBuffers(buffers);
+    return result;
+}
+
+template <typename Weight>
+std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>> DijkstraRouter<Weight>::BuildRoutes(
+    VertexId from, const std::vector<VertexId>& targets) const {
+    if (from >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    SearchBuffers& buffers = GetSearchBuffers(graph_.GetVertexCount());
+    auto& is_target = buffers.is_target;
+    auto& prev_edges = buffers.prev_edges;
+    SearchTargets(buffers, from, MarkTargets(buffers, targets));
+
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (const VertexId target : targets) {
+        if (is_target[target]) {
+            routes.emplace_back();
+            continue;
+        }
+        std::vector<EdgeId> edges;
+        for (std::optional<EdgeId> edge_id = prev_edges[target];
+            edge_id;
+            edge_id = prev_edges[graph_.GetEdge(*edge_id).from])
+        {
+            edges.push_back(*edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+        routes.push_back(RouteInfo{ *buffers.distances[target], std::move(edges) });
+    }
+    for (const VertexId target : targets) {
+        is_target[target] = false;
+    }
+
+    ResetSearchBuffers(buffers);
+    return routes;
+}
+
+}  // namespace graph
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace graph {
+
+// Движок по копии графа с целыми весами: вес w заменяется на round(w * scale).
+// Целые веса вдвое короче double и сравниваются без плавающей точки, а вес
+// найденного маршрута считается по исходным рёбрам.
+// Граница ошибки: каждое ребро округляется не больше чем на половину единицы,
+// поэтому найденный маршрут P длиннее кратчайшего O не больше чем на
+// (|P| + |O|) / (2 * scale), где |P| и |O| - число рёбер в них
+template <typename Weight, typename FixedWeight>
+class FixedPointRouter : public RouterBase<Weight> {
+    static_assert(std::is_integral_v<FixedWeight> && std::is_unsigned_v<FixedWeight>);
+
+public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+    using FixedGraph = DirectedWeightedGraph<FixedWeight>;
+    // Создаёт движок по графу с целыми весами; граф живёт, пока жив FixedPointRouter
+    using RouterFactory = std::function<std::unique_ptr<RouterBase<FixedWeight>>(const FixedGraph&)>;
+
+    // Вес ребра после округления, на случай сумм двух весов, не больше половины типа
+    static constexpr FixedWeight MAX_EDGE_WEIGHT = std::numeric_limits<FixedWeight>::max() / 2 - 1;
+
+    FixedPointRouter(const DirectedWeightedGraph<Weight>& graph, Weight scale, const RouterFactory& create_router);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    std::optional<RouteInfo> BuildMonitoredRoute(VertexId from, VertexId to, SearchMonitor& monitor) const override;
+
+    const FixedGraph& GetFixedGraph() const {
+        return fixed_graph_;
+    }
+
+    const RouterBase<FixedWeight>& GetRouter() const {
+        return *router_;
+    }
+
+private:
+    static FixedGraph ToFixedPoint(const DirectedWeightedGraph<Weight>& graph, Weight scale);
+
+    // Маршрут с весом по исходным рёбрам
+    std::optional<RouteInfo> ToRoute(std::optional<graph::RouteInfo<FixedWeight>> fixed_route) const;
+
+    const DirectedWeightedGraph<Weight>& graph_;
+    FixedGraph fixed_graph_;
+    std::unique_ptr<RouterBase<FixedWeight>> router_;
+};
+
+template <typename Weight, typename FixedWeight>
+FixedPointRouter<Weight, FixedWeight>::FixedPointRouter(const DirectedWeightedGraph<Weight>& graph, Weight scale,
+    const RouterFactory& create_router)
+    : graph_(graph)
+    , fixed_graph_(ToFixedPoint(graph, scale))
+    , router_(create_router(fixed_graph_))
+{
+}
+
+template <typename Weight, typename FixedWeight>
+typename FixedPointRouter<Weight, FixedWeight>::FixedGraph FixedPointRouter<Weight, FixedWeight>::ToFixedPoint(
+    const DirectedWeightedGraph<Weight>& graph, Weight scale) {
+    FixedGraph fixed_graph(graph.GetVertexCount());
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        const Weight fixed_weight = std::round(edge.weight * scale);
+        if (!(fixed_weight >= 0) || fixed_weight > static_cast<Weight>(MAX_EDGE_WEIGHT)) {
+            throw std::out_of_range("Edge weight doesn't fit the fixed-point type");
+        }
+        fixed_graph.AddEdge({ edge.name_id, edge.quality, edge.from, edge.to, static_cast<FixedWeight>(fixed_weight) });
+    }
+    fixed_graph.Freeze();
+    return fixed_graph;
+}
+
+template <typename Weight, typename FixedWeight>
+std::optional<typename FixedPointRouter<Weight, FixedWeight>::RouteInfo> FixedPointRouter<Weight, FixedWeight>::BuildRoute(
+    VertexId from, VertexId to) const {
+    return ToRoute(router_->BuildRoute(from, to));
+}
+
+template <typename Weight, typename FixedWeight>
+std::optional<typename FixedPointRouter<Weight, FixedWeight>::RouteInfo> FixedPointRouter<Weight, FixedWeight>::
+    BuildMonitoredRoute(VertexId from, VertexId to, SearchMonitor& monitor) const {
+    return ToRoute(router_->BuildMonitoredRoute(from, to, monitor));
+}
+
+template <typename Weight, typename FixedWeight>
+std::optional<typename FixedPointRouter<Weight, FixedWeight>::RouteInfo> FixedPointRouter<Weight, FixedWeight>::ToRoute(
+    std::optional<graph::RouteInfo<FixedWeight>> fixed_route) const {
+    if (!fixed_route) {
+        return std::nullopt;
+    }
+    Weight weight{};
+    for (const EdgeId edge_id : fixed_route->edges) {
+        weight += graph_.GetEdge(edge_id).weight;
+    }
+    return RouteInfo{ weight, std::move(fixed_route->edges) };
+}
+
+}  // namespace graph
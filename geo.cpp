@@ -3,6 +3,7 @@
 #include "geo.h"
 
 #include <cmath>
+#include <utility>
 
 
 namespace geo {
@@ -16,4 +17,33 @@ namespace geo {
                     + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
                * 6371000;
     }
+
+    std::uint64_t ComputeHilbertIndex(Coordinates point, Coordinates min, Coordinates max) {
+        constexpr std::uint32_t side = 1u << 16;
+        const auto to_cell = [side](double value, double min_value, double max_value) {
+            if (!(max_value > min_value)) {
+                return std::uint32_t{0};
+            }
+            const double cell = (value - min_value) / (max_value - min_value) * (side - 1);
+            return static_cast<std::uint32_t>(std::fmin(std::fmax(std::round(cell), 0.0), side - 1.0));
+        };
+        std::uint32_t x = to_cell(point.lng, min.lng, max.lng);
+        std::uint32_t y = to_cell(point.lat, min.lat, max.lat);
+
+        std::uint64_t index = 0;
+        for (std::uint32_t s = side / 2; s > 0; s /= 2) {
+            const std::uint32_t rx = (x & s) ? 1 : 0;
+            const std::uint32_t ry = (y & s) ? 1 : 0;
+            index += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+            // Поворот четверти, чтобы кривая в ней шла в стандартном направлении
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = side - 1 - x;
+                    y = side - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return index;
+    }
 } // namespace geo
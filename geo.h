@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 
 namespace geo {
     struct Coordinates {
@@ -17,4 +18,8 @@ namespace geo {
     };
 
     double ComputeDistance(Coordinates from, Coordinates to);
+
+    // Номер точки на кривой Гильберта порядка 16, проведённой по
+    // прямоугольнику [min, max]: близкие номера у близких точек
+    std::uint64_t ComputeHilbertIndex(Coordinates point, Coordinates min, Coordinates max);
 } // namespace geo
@@ -2,9 +2,12 @@
 
 #include "ranges.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <iterator>
+#include <stdexcept>
 #include <vector>
-#include <string>
 
 namespace graph {
 
@@ -13,18 +16,68 @@ namespace graph {
 
     template <typename Weight>
     struct Edge {
-        std::string name;
+        // Ребро ожидания (quality == 0) хранит id остановки, ребро поездки - id автобуса
+        std::uint32_t name_id;
         size_t quality;
         VertexId from;
         VertexId to;
         Weight weight;
     };
 
+    // Исходящее ребро из горячих массивов замороженного графа
+    template <typename Weight>
+    struct OutgoingEdge {
+        EdgeId id;
+        VertexId to;
+        Weight weight;
+    };
+
+    template <typename Weight>
+    class OutgoingEdgeIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = OutgoingEdge<Weight>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = OutgoingEdge<Weight>;
+
+        OutgoingEdgeIterator(const EdgeId* ids, const VertexId* targets, const Weight* weights)
+                : ids_(ids)
+                , targets_(targets)
+                , weights_(weights) {
+        }
+
+        OutgoingEdge<Weight> operator*() const {
+            return { *ids_, *targets_, *weights_ };
+        }
+
+        OutgoingEdgeIterator& operator++() {
+            ++ids_;
+            ++targets_;
+            ++weights_;
+            return *this;
+        }
+
+        bool operator==(const OutgoingEdgeIterator& other) const {
+            return ids_ == other.ids_;
+        }
+
+        bool operator!=(const OutgoingEdgeIterator& other) const {
+            return ids_ != other.ids_;
+        }
+
+    private:
+        const EdgeId* ids_;
+        const VertexId* targets_;
+        const Weight* weights_;
+    };
+
     template <typename Weight>
     class DirectedWeightedGraph {
     private:
         using IncidenceList = std::vector<EdgeId>;
         using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+        using OutgoingEdgesRange = ranges::Range<OutgoingEdgeIterator<Weight>>;
 
     public:
         DirectedWeightedGraph() = default;
@@ -33,14 +86,28 @@ namespace graph {
                                        std::vector<std::vector<EdgeId>> incidence_lists);
         EdgeId AddEdge(const Edge<Weight>& edge);
 
+        // Переводит граф в CSR: рёбра вершины лежат подряд, а их концы и веса -
+        // в отдельных плотных массивах для циклов поиска. Имена и число
+        // пролётов остаются в Edge и нужны только при сборке ответа.
+        // После заморозки рёбра добавлять нельзя
+        void Freeze();
+        bool IsFrozen() const;
+
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
         const Edge<Weight>& GetEdge(EdgeId edge_id) const;
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+        OutgoingEdgesRange GetOutgoingEdges(VertexId vertex) const;
 
     private:
         std::vector<Edge<Weight>> edges_;
         std::vector<IncidenceList> incidence_lists_;
+
+        bool frozen_ = false;
+        std::vector<size_t> offsets_;
+        std::vector<EdgeId> edge_ids_;
+        std::vector<VertexId> targets_;
+        std::vector<Weight> weights_;
     };
 
     template <typename Weight>
@@ -57,15 +124,45 @@ namespace graph {
 
     template <typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+        if (frozen_) {
+            throw std::logic_error("Can't add an edge to a frozen graph");
+        }
         edges_.push_back(edge);
         const EdgeId id = edges_.size() - 1;
         incidence_lists_.at(edge.from).push_back(id);
         return id;
     }
 
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::Freeze() {
+        if (frozen_) {
+            return;
+        }
+        offsets_.reserve(incidence_lists_.size() + 1);
+        offsets_.push_back(0);
+        edge_ids_.reserve(edges_.size());
+        targets_.reserve(edges_.size());
+        weights_.reserve(edges_.size());
+        for (const IncidenceList& incidence_list : incidence_lists_) {
+            for (const EdgeId edge_id : incidence_list) {
+                edge_ids_.push_back(edge_id);
+                targets_.push_back(edges_[edge_id].to);
+                weights_.push_back(edges_[edge_id].weight);
+            }
+            offsets_.push_back(edge_ids_.size());
+        }
+        incidence_lists_ = {};
+        frozen_ = true;
+    }
+
+    template <typename Weight>
+    bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+        return frozen_;
+    }
+
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-        return incidence_lists_.size();
+        return frozen_ ? offsets_.size() - 1 : incidence_lists_.size();
     }
 
     template <typename Weight>
@@ -81,7 +178,30 @@ namespace graph {
     template <typename Weight>
     typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
     DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-        return ranges::AsRange(incidence_lists_.at(vertex));
+        if (!frozen_) {
+            return ranges::AsRange(incidence_lists_.at(vertex));
+        }
+        if (vertex >= GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        return { edge_ids_.begin() + offsets_[vertex], edge_ids_.begin() + offsets_[vertex + 1] };
+    }
+
+    template <typename Weight>
+    typename DirectedWeightedGraph<Weight>::OutgoingEdgesRange
+    DirectedWeightedGraph<Weight>::GetOutgoingEdges(VertexId vertex) const {
+        if (!frozen_) {
+            throw std::logic_error("Outgoing edges are available only in a frozen graph");
+        }
+        if (vertex >= GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        const size_t begin = offsets_[vertex];
+        const size_t end = offsets_[vertex + 1];
+        return {
+                OutgoingEdgeIterator<Weight>(edge_ids_.data() + begin, targets_.data() + begin, weights_.data() + begin),
+                OutgoingEdgeIterator<Weight>(edge_ids_.data() + end, targets_.data() + end, weights_.data() + end)
+        };
     }
 
 } // namespace graph
@@ -0,0 +1,299 @@
+#pragma once
+
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Двухуровневые метки (hub labeling): у каждой вершины есть прямые метки -
+// расстояния до хабов, и обратные - расстояния от хабов. Кратчайшее расстояние
+// от from до to - минимум по общим хабам, то есть одно слияние двух
+// отсортированных массивов. Метки строятся pruned landmark labeling'ом
+template <typename Weight>
+class HubLabelRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+    using HubRank = std::uint32_t;
+
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    // Метки всех вершин подряд, метки одной вершины отсортированы по рангу хаба.
+    // edges - первое ребро пути до хаба для прямых меток и последнее ребро
+    // пути от хаба для обратных, NO_EDGE у метки вершины на саму себя
+    struct Labels {
+        std::vector<size_t> offsets;
+        std::vector<HubRank> hubs;
+        std::vector<Weight> distances;
+        std::vector<EdgeId> edges;
+    };
+
+    struct Index {
+        Labels forward;
+        Labels backward;
+    };
+
+    explicit HubLabelRouter(const Graph& graph);
+    HubLabelRouter(const Graph& graph, Index index);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    const Index& GetIndex() const {
+        return index_;
+    }
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    struct Label {
+        HubRank hub;
+        Weight distance;
+        EdgeId edge;
+    };
+
+    void BuildIndex();
+    void RunPrunedSearch(HubRank hub, VertexId hub_vertex, bool forward,
+        const std::vector<std::vector<EdgeId>>& incidence_lists,
+        std::vector<std::vector<Label>>& labels, const std::vector<std::vector<Label>>& hub_side_labels,
+        std::vector<std::optional<Weight>>& hub_distances, std::vector<std::optional<Weight>>& distances,
+        std::vector<EdgeId>& parent_edges) const;
+    static Labels Compact(const std::vector<std::vector<Label>>& labels);
+
+    std::optional<size_t> FindLabel(const Labels& labels, VertexId vertex, HubRank hub) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    Index index_;
+};
+
+template <typename Weight>
+HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    BuildIndex();
+}
+
+template <typename Weight>
+HubLabelRouter<Weight>::HubLabelRouter(const Graph& graph, Index index)
+    : graph_(graph)
+    , index_(std::move(index))
+{
+    for (const Labels* labels : { &index_.forward, &index_.backward }) {
+        if (labels->offsets.size() != graph.GetVertexCount() + 1
+            || labels->hubs.size() != labels->offsets.back()
+            || labels->distances.size() != labels->hubs.size()
+            || labels->edges.size() != labels->hubs.size()) {
+            throw std::invalid_argument("Hub labels don't match the graph");
+        }
+    }
+}
+
+template <typename Weight>
+void HubLabelRouter<Weight>::BuildIndex() {
+    const size_t vertex_count = graph_.GetVertexCount();
+
+    std::vector<std::vector<EdgeId>> out_edges(vertex_count);
+    std::vector<std::vector<EdgeId>> in_edges(vertex_count);
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        out_edges[edge.from].push_back(edge_id);
+        in_edges[edge.to].push_back(edge_id);
+    }
+
+    // Хабами раньше становятся вершины с большей степенью: через них проходит
+    // больше кратчайших путей, и метки остальных вершин получаются короче
+    std::vector<VertexId> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&out_edges, &in_edges](VertexId lhs, VertexId rhs) {
+        return out_edges[lhs].size() + in_edges[lhs].size() > out_edges[rhs].size() + in_edges[rhs].size();
+    });
+
+    std::vector<std::vector<Label>> forward_labels(vertex_count);
+    std::vector<std::vector<Label>> backward_labels(vertex_count);
+    std::vector<std::optional<Weight>> hub_distances(vertex_count);
+    std::vector<std::optional<Weight>> distances(vertex_count);
+    std::vector<EdgeId> parent_edges(vertex_count, NO_EDGE);
+
+    for (HubRank hub = 0; hub < vertex_count; ++hub) {
+        const VertexId hub_vertex = order[hub];
+        RunPrunedSearch(hub, hub_vertex, true, out_edges, backward_labels, forward_labels,
+            hub_distances, distances, parent_edges);
+        RunPrunedSearch(hub, hub_vertex, false, in_edges, forward_labels, backward_labels,
+            hub_distances, distances, parent_edges);
+    }
+
+    index_.forward = Compact(forward_labels);
+    index_.backward = Compact(backward_labels);
+}
+
+// Прямой поиск от хаба дописывает хаб в обратные метки достигнутых вершин,
+// обратный - в прямые. Вершина отсекается, если уже построенные метки дают
+// путь не длиннее найденного
+template <typename Weight>
+void HubLabelRouter<Weight>::RunPrunedSearch(HubRank hub, VertexId hub_vertex, bool forward,
+    const std::vector<std::vector<EdgeId>>& incidence_lists,
+    std::vector<std::vector<Label>>& labels, const std::vector<std::vector<Label>>& hub_side_labels,
+    std::vector<std::optional<Weight>>& hub_distances, std::vector<std::optional<Weight>>& distances,
+    std::vector<EdgeId>& parent_edges) const {
+    for (const Label& label : hub_side_labels[hub_vertex]) {
+        hub_distances[label.hub] = label.distance;
+    }
+
+    std::vector<VertexId> touched_vertices{ hub_vertex };
+    std::vector<QueueItem> queue{ { ZERO_WEIGHT, hub_vertex } };
+    const auto queue_compare = std::greater<QueueItem>{};
+    distances[hub_vertex] = ZERO_WEIGHT;
+
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), queue_compare);
+        const auto [weight, vertex] = queue.back();
+        queue.pop_back();
+
+        if (*distances[vertex] < weight) {
+            continue;
+        }
+
+        bool covered = false;
+        for (const Label& label : labels[vertex]) {
+            if (hub_distances[label.hub] && !(weight < *hub_distances[label.hub] + label.distance)) {
+                covered = true;
+                break;
+            }
+        }
+        if (covered) {
+            continue;
+        }
+        labels[vertex].push_back({ hub, weight, parent_edges[vertex] });
+
+        for (const EdgeId edge_id : incidence_lists[vertex]) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const VertexId next = forward ? edge.to : edge.from;
+            const Weight candidate_weight = weight + edge.weight;
+            auto& distance = distances[next];
+            if (!distance || candidate_weight < *distance) {
+                if (!distance) {
+                    touched_vertices.push_back(next);
+                }
+                distance = candidate_weight;
+                parent_edges[next] = edge_id;
+                queue.push_back({ candidate_weight, next });
+                std::push_heap(queue.begin(), queue.end(), queue_compare);
+            }
+        }
+    }
+
+    for (const VertexId vertex : touched_vertices) {
+        distances[vertex].reset();
+        parent_edges[vertex] = NO_EDGE;
+    }
+    for (const Label& label : hub_side_labels[hub_vertex]) {
+        hub_distances[label.hub].reset();
+    }
+}
+
+template <typename Weight>
+typename HubLabelRouter<Weight>::Labels HubLabelRouter<Weight>::Compact(
+    const std::vector<std::vector<Label>>& labels) {
+    Labels result;
+    result.offsets.reserve(labels.size() + 1);
+    result.offsets.push_back(0);
+    for (const auto& vertex_labels : labels) {
+        result.offsets.push_back(result.offsets.back() + vertex_labels.size());
+    }
+    result.hubs.reserve(result.offsets.back());
+    result.distances.reserve(result.offsets.back());
+    result.edges.reserve(result.offsets.back());
+    for (const auto& vertex_labels : labels) {
+        for (const Label& label : vertex_labels) {
+            result.hubs.push_back(label.hub);
+            result.distances.push_back(label.distance);
+            result.edges.push_back(label.edge);
+        }
+    }
+    return result;
+}
+
+template <typename Weight>
+std::optional<size_t> HubLabelRouter<Weight>::FindLabel(const Labels& labels, VertexId vertex,
+    HubRank hub) const {
+    const auto begin = labels.hubs.begin() + labels.offsets[vertex];
+    const auto end = labels.hubs.begin() + labels.offsets[vertex + 1];
+    const auto it = std::lower_bound(begin, end, hub);
+    if (it == end || *it != hub) {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(it - labels.hubs.begin());
+}
+
+template <typename Weight>
+std::optional<typename HubLabelRouter<Weight>::RouteInfo> HubLabelRouter<Weight>::BuildRoute(VertexId from,
+    VertexId to) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const Labels& forward = index_.forward;
+    const Labels& backward = index_.backward;
+
+    std::optional<Weight> best_weight;
+    HubRank best_hub = 0;
+    size_t i = forward.offsets[from];
+    size_t j = backward.offsets[to];
+    while (i < forward.offsets[from + 1] && j < backward.offsets[to + 1]) {
+        if (forward.hubs[i] < backward.hubs[j]) {
+            ++i;
+        } else if (backward.hubs[j] < forward.hubs[i]) {
+            ++j;
+        } else {
+            const Weight candidate_weight = forward.distances[i] + backward.distances[j];
+            if (!best_weight || candidate_weight < *best_weight) {
+                best_weight = candidate_weight;
+                best_hub = forward.hubs[i];
+            }
+            ++i;
+            ++j;
+        }
+    }
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (VertexId vertex = from;;) {
+        const EdgeId edge_id = forward.edges[*FindLabel(forward, vertex, best_hub)];
+        if (edge_id == NO_EDGE) {
+            break;
+        }
+        edges.push_back(edge_id);
+        vertex = graph_.GetEdge(edge_id).to;
+    }
+    const size_t forward_size = edges.size();
+    for (VertexId vertex = to;;) {
+        const EdgeId edge_id = backward.edges[*FindLabel(backward, vertex, best_hub)];
+        if (edge_id == NO_EDGE) {
+            break;
+        }
+        edges.push_back(edge_id);
+        vertex = graph_.GetEdge(edge_id).from;
+    }
+    std::reverse(edges.begin() + forward_size, edges.end());
+
+    return RouteInfo{ *best_weight, std::move(edges) };
+}
+
+}  // namespace graph
@@ -1,6 +1,10 @@
 #include "json_reader.h"
 
+#include <chrono>
+#include <map>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 
@@ -68,6 +72,23 @@ namespace json_reader {
         BusesHandler(base_requests, transport_catalogue);
     }
 
+    // Запросы к уже готовой базе: только новые автобусы по существующим остановкам
+    void JsonReader::UpdateRequestsHandler(transport_catalogue::TransportCatalogue &transport_catalogue) {
+        Array base_requests = document_.GetRoot().AsMap().at("base_requests"s).AsArray();
+
+        const auto buses = transport_catalogue.GetSortedBuses();
+        for (const Node &node_map: base_requests) {
+            if (node_map.AsMap().at("type"s).AsString() != "Bus"s) {
+                throw std::invalid_argument("Only new buses can be added to an existing base");
+            }
+            if (buses.count(node_map.AsMap().at("name"s).AsString())) {
+                throw std::invalid_argument("Bus already exists: "s + node_map.AsMap().at("name"s).AsString());
+            }
+        }
+
+        BusesHandler(base_requests, transport_catalogue);
+    }
+
     //------------------------------------------------------------------------------------------------------------------
     svg::Color JsonReader::ColorDeterminant(const Node &node) {
         svg::Color color;
@@ -125,21 +146,140 @@ namespace json_reader {
     }
 
     //------------------------------------------------------------------------------------------------------------------
+    transport_router::TransportRouter::RouterType JsonReader::RouterTypeDeterminant(const Node &router_type) {
+        using RouterType = transport_router::TransportRouter::RouterType;
+
+        const string &name = router_type.AsString();
+        if (name == "floyd_warshall"s) {
+            return RouterType::FLOYD_WARSHALL;
+        } else if (name == "dijkstra"s) {
+            return RouterType::DIJKSTRA;
+        } else if (name == "contraction_hierarchy"s) {
+            return RouterType::CONTRACTION_HIERARCHY;
+        } else if (name == "hub_labels"s) {
+            return RouterType::HUB_LABELS;
+        } else if (name == "raptor"s) {
+            return RouterType::RAPTOR;
+        } else if (name == "a_star"s) {
+            return RouterType::A_STAR;
+        } else if (name == "cell_overlay"s) {
+            return RouterType::CELL_OVERLAY;
+        }
+        throw std::invalid_argument("Unknown router type: "s + name);
+    }
+
+    transport_router::TransportRouter::GraphModel JsonReader::GraphModelDeterminant(const Node &graph_model) {
+        using GraphModel = transport_router::TransportRouter::GraphModel;
+
+        const string &name = graph_model.AsString();
+        if (name == "stop_pairs"s) {
+            return GraphModel::STOP_PAIRS;
+        } else if (name == "bus_chain"s) {
+            return GraphModel::BUS_CHAIN;
+        }
+        throw std::invalid_argument("Unknown graph model: "s + name);
+    }
+
+    transport_router::TransportRouter::VertexOrder JsonReader::VertexOrderDeterminant(const Node &vertex_order) {
+        using VertexOrder = transport_router::TransportRouter::VertexOrder;
+
+        const string &name = vertex_order.AsString();
+        if (name == "name"s) {
+            return VertexOrder::NAME;
+        } else if (name == "hilbert"s) {
+            return VertexOrder::HILBERT;
+        } else if (name == "bfs"s) {
+            return VertexOrder::BFS;
+        }
+        throw std::invalid_argument("Unknown vertex order: "s + name);
+    }
+
     transport_router::TransportRouter::RoutingSettings JsonReader::GetRoutingSettings() const {
-        return {
-                document_.GetRoot().AsMap().at("routing_settings"s).AsMap().at("bus_wait_time"s).AsInt(),
-                document_.GetRoot().AsMap().at("routing_settings"s).AsMap().at("bus_velocity"s).AsDouble()
-        };
+        Dict routing_settings_requests = document_.GetRoot().AsMap().at("routing_settings"s).AsMap();
+
+        transport_router::TransportRouter::RoutingSettings routing_settings;
+
+        routing_settings.bus_wait_time_ = routing_settings_requests.at("bus_wait_time"s).AsInt();
+        routing_settings.bus_velocity_ = routing_settings_requests.at("bus_velocity"s).AsDouble();
+
+        if (routing_settings_requests.count("router_type"s)) {
+            routing_settings.router_type_ = RouterTypeDeterminant(routing_settings_requests.at("router_type"s));
+        }
+
+        if (routing_settings_requests.count("route_cache_size"s)) {
+            routing_settings.route_cache_size_ = routing_settings_requests.at("route_cache_size"s).AsInt();
+        }
+
+        if (routing_settings_requests.count("graph_model"s)) {
+            routing_settings.graph_model_ = GraphModelDeterminant(routing_settings_requests.at("graph_model"s));
+        }
+
+        if (routing_settings_requests.count("wait_on_boarding"s)) {
+            routing_settings.wait_on_boarding_ = routing_settings_requests.at("wait_on_boarding"s).AsBool();
+        }
+
+        if (routing_settings_requests.count("fixed_point_weights"s)) {
+            routing_settings.fixed_point_weights_ = routing_settings_requests.at("fixed_point_weights"s).AsBool();
+        }
+
+        if (routing_settings_requests.count("overlay_cell_size"s)) {
+            routing_settings.overlay_cell_size_ = routing_settings_requests.at("overlay_cell_size"s).AsInt();
+        }
+
+        if (routing_settings_requests.count("vertex_order"s)) {
+            routing_settings.vertex_order_ = VertexOrderDeterminant(routing_settings_requests.at("vertex_order"s));
+        }
+
+        return routing_settings;
     }
 
     //------------------------------------------------------------------------------------------------------------------
+    vector<optional<Node>> JsonReader::RouteRequestsHandler(
+            const Array &stat_requests,
+            request_handler::RequestHandler &request_handler
+    ) {
+        struct RouteRequests {
+            vector<size_t> indexes;
+            vector<int> ids;
+            vector<string_view> final_stops;
+        };
+        map<string_view, RouteRequests> requests_by_source;
+        for (size_t i = 0; i < stat_requests.size(); ++i) {
+            const Dict &request = stat_requests[i].AsMap();
+            if (request.at("type"s).AsString() != "Route"s
+                || request.count("bus_wait_time"s) || request.count("bus_velocity"s)
+                || request.count("explain"s) || request.count("deadline_us"s) || request.count("via"s)) {
+                continue;
+            }
+            RouteRequests &requests = requests_by_source[request.at("from"s).AsString()];
+            requests.indexes.push_back(i);
+            requests.ids.push_back(request.at("id"s).AsInt());
+            requests.final_stops.push_back(request.at("to"s).AsString());
+        }
+
+        vector<optional<Node>> responses(stat_requests.size());
+        for (const auto &[start_stop, requests]: requests_by_source) {
+            vector<Node> nodes = request_handler.RouteBatchHandler(requests.ids, start_stop, requests.final_stops);
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                responses[requests.indexes[i]] = std::move(nodes[i]);
+            }
+        }
+        return responses;
+    }
+
     void JsonReader::PrintJsonResponse(std::ostream &out, request_handler::RequestHandler& request_handler) {
         Array stat_requests = document_.GetRoot().AsMap().at("stat_requests"s).AsArray();
 
         Array response;
         response.reserve(stat_requests.size());
 
-        for (const Node &node_map: stat_requests) {
+        vector<optional<Node>> route_responses = RouteRequestsHandler(stat_requests, request_handler);
+        for (size_t i = 0; i < stat_requests.size(); ++i) {
+            const Node &node_map = stat_requests[i];
+            if (route_responses[i]) {
+                response.push_back(std::move(*route_responses[i]));
+                continue;
+            }
             string type = node_map.AsMap().at("type"s).AsString();
             if (type == "Stop"s) {
                 response.push_back(
@@ -156,13 +296,56 @@ namespace json_reader {
                         )
                 );
             } else if (type == "Route"s) {
+                transport_router::TransportRouter::RouteOverrides overrides;
+                if (node_map.AsMap().count("bus_wait_time"s)) {
+                    overrides.bus_wait_time_ = node_map.AsMap().at("bus_wait_time"s).AsInt();
+                }
+                if (node_map.AsMap().count("bus_velocity"s)) {
+                    overrides.bus_velocity_ = node_map.AsMap().at("bus_velocity"s).AsDouble();
+                }
+                vector<string_view> via;
+                if (node_map.AsMap().count("via"s)) {
+                    for (const Node &stop_name: node_map.AsMap().at("via"s).AsArray()) {
+                        via.push_back(stop_name.AsString());
+                    }
+                }
+                request_handler::RouteSearchOptions search_options;
+                if (node_map.AsMap().count("explain"s)) {
+                    search_options.explain = node_map.AsMap().at("explain"s).AsBool();
+                }
+                if (node_map.AsMap().count("deadline_us"s)) {
+                    search_options.deadline = chrono::microseconds(node_map.AsMap().at("deadline_us"s).AsInt());
+                }
                 response.push_back(
                         request_handler.RouterHandler(
                                 node_map.AsMap().at("id"s).AsInt(),
                                 node_map.AsMap().at("from"s).AsString(),
-                                node_map.AsMap().at("to"s).AsString()
+                                node_map.AsMap().at("to"s).AsString(),
+                                via,
+                                overrides,
+                                search_options
                         )
                 );
+            } else if (type == "Reachable"s) {
+                response.push_back(
+                        request_handler.ReachableHandler(
+                                node_map.AsMap().at("id"s).AsInt(),
+                                node_map.AsMap().at("from"s).AsString(),
+                                node_map.AsMap().at("max_time"s).AsDouble()
+                        )
+                );
+            } else if (type == "Matrix"s) {
+                vector<string_view> sources;
+                for (const Node &stop_name: node_map.AsMap().at("sources"s).AsArray()) {
+                    sources.push_back(stop_name.AsString());
+                }
+                vector<string_view> targets;
+                for (const Node &stop_name: node_map.AsMap().at("targets"s).AsArray()) {
+                    targets.push_back(stop_name.AsString());
+                }
+                response.push_back(
+                        request_handler.MatrixHandler(node_map.AsMap().at("id"s).AsInt(), sources, targets)
+                );
             } else if (type == "Map"s) {
                 response.push_back(request_handler.MapRequestHandler(node_map.AsMap().at("id"s).AsInt()));
             }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -23,13 +24,26 @@ namespace json_reader {
         void StopsHandler(const Array &base_requests, TransportCatalogue &transport_catalogue);
         void BusesHandler(const Array &base_requests, TransportCatalogue &transport_catalogue);
         void BaseRequestsHandler(TransportCatalogue &transport_catalogue);
+        void UpdateRequestsHandler(TransportCatalogue &transport_catalogue);
 
         void PrintJsonResponse(std::ostream &out,request_handler::RequestHandler& request_handler);
 
         std::string GetSerializationSettings() const;
         renderer::MapRenderer::RenderSettings GetRenderSettings() const;
         transport_router::TransportRouter::RoutingSettings GetRoutingSettings() const;
+
+        static transport_router::TransportRouter::RouterType RouterTypeDeterminant(const Node &router_type);
+        static transport_router::TransportRouter::GraphModel GraphModelDeterminant(const Node &graph_model);
+        static transport_router::TransportRouter::VertexOrder VertexOrderDeterminant(const Node &vertex_order);
     private:
         static svg::Color ColorDeterminant(const Node &color);
+
+        // Отвечает на запросы Route без своих настроек, сгруппировав их по
+        // остановке from: один поиск на остановку. Ответ на i-й запрос
+        // stat_requests - в i-м элементе, на остальные запросы - пусто
+        static std::vector<std::optional<Node>> RouteRequestsHandler(
+                const Array &stat_requests,
+                request_handler::RequestHandler &request_handler
+        );
     };
 }
@@ -1,3 +1,4 @@
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <string>
@@ -5,6 +6,7 @@
 #include "transport_catalogue.h"
 #include "json_reader.h"
 #include "serialization.h"
+#include "router_benchmark.h"
 
 using namespace std::literals;
 
@@ -36,11 +38,9 @@ int main(int argc, char *argv[]) {
             );
         }
     } else if (mode == "process_requests"s) {
-        std::ifstream db_file(serialization_settings, std::ios::binary);
+        const auto db_file = serialization::MappedFile::Open(serialization_settings);
         if (db_file) {
-            auto [transport_catalogue, map_renderer, transport_router, graph, stop_ids] = serialization::Deserialize(db_file);
-
-            transport_router.FillRouter(graph, stop_ids);
+            auto [transport_catalogue, map_renderer, transport_router] = serialization::Deserialize(db_file);
 
             request_handler::RequestHandler request_handler_(
                     transport_catalogue,
@@ -50,6 +50,53 @@ int main(int argc, char *argv[]) {
 
             json_reader_.PrintJsonResponse(std::cout, request_handler_);
         }
+    } else if (mode == "update_base"s) {
+        const auto db_file = serialization::MappedFile::Open(serialization_settings);
+        if (!db_file) {
+            return 1;
+        }
+        auto [transport_catalogue, map_renderer, transport_router] = serialization::Deserialize(db_file);
+        json_reader_.UpdateRequestsHandler(transport_catalogue);
+        transport_router.AddBuses(transport_catalogue);
+
+        renderer::MapRenderer updated_map_renderer(
+                map_renderer.GetRenderSettings(),
+                transport_catalogue.GetSortedBuses()
+        );
+
+        // Старая база отображена в память, поэтому новая пишется рядом и
+        // подменяет её целиком
+        const std::string updated_file = serialization_settings + ".tmp"s;
+        {
+            std::ofstream fout(updated_file, std::ios::binary);
+            if (!fout.is_open()) {
+                return 1;
+            }
+            serialization::Serialize(
+                    transport_catalogue,
+                    updated_map_renderer,
+                    transport_router,
+                    fout
+            );
+        }
+        if (std::rename(updated_file.c_str(), serialization_settings.c_str()) != 0) {
+            return 1;
+        }
+    } else if (mode == "benchmark"s) {
+        transport_catalogue::TransportCatalogue transport_catalogue_;
+        json_reader_.BaseRequestsHandler(transport_catalogue_);
+
+        std::vector<std::string> router_types(argv + 2, argv + argc);
+        if (router_types.empty()) {
+            router_types = {"floyd_warshall"s, "dijkstra"s, "contraction_hierarchy"s, "hub_labels"s, "raptor"s, "a_star"s, "cell_overlay"s};
+        }
+
+        router_benchmark::PrintBenchmark(
+                transport_catalogue_,
+                json_reader_.GetRoutingSettings(),
+                router_types,
+                std::cout
+        );
     } else {
         return 1;
     }
@@ -0,0 +1,529 @@
+#pragma once
+
+#include "router.h"
+#include "geo.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Ячейки по cell_size вершин подряд вдоль кривой Гильберта по координатам
+// вершин: каждая ячейка - компактный участок карты
+inline std::vector<std::uint32_t> PartitionByHilbertCurve(const std::vector<geo::Coordinates>& coordinates,
+    size_t cell_size) {
+    if (cell_size == 0) {
+        throw std::invalid_argument("Cell size should be positive");
+    }
+    std::vector<std::uint32_t> vertex_cells(coordinates.size());
+    if (coordinates.empty()) {
+        return vertex_cells;
+    }
+    geo::Coordinates min = coordinates.front();
+    geo::Coordinates max = min;
+    for (const geo::Coordinates& point : coordinates) {
+        min.lat = std::min(min.lat, point.lat);
+        min.lng = std::min(min.lng, point.lng);
+        max.lat = std::max(max.lat, point.lat);
+        max.lng = std::max(max.lng, point.lng);
+    }
+    std::vector<std::pair<std::uint64_t, VertexId>> indexed_vertices;
+    indexed_vertices.reserve(coordinates.size());
+    for (VertexId vertex = 0; vertex < coordinates.size(); ++vertex) {
+        indexed_vertices.emplace_back(geo::ComputeHilbertIndex(coordinates[vertex], min, max), vertex);
+    }
+    std::sort(indexed_vertices.begin(), indexed_vertices.end());
+    for (size_t i = 0; i < indexed_vertices.size(); ++i) {
+        vertex_cells[indexed_vertices[i].second] = static_cast<std::uint32_t>(i / cell_size);
+    }
+    return vertex_cells;
+}
+
+// Разбиение графа на ячейки. Граничная вершина ячейки - конец ребра между
+// разными ячейками. Для каждой ячейки хранится матрица переходов между её
+// граничными вершинами, матрицы всех ячеек идут подряд
+class GraphPartition {
+public:
+    static constexpr std::uint32_t NO_BOUNDARY_ID = UINT32_MAX;
+
+    template <typename Weight>
+    GraphPartition(const DirectedWeightedGraph<Weight>& graph, std::vector<std::uint32_t> vertex_cells);
+
+    size_t GetVertexCount() const {
+        return vertex_cells_.size();
+    }
+
+    size_t GetCellCount() const {
+        return vertex_offsets_.size() - 1;
+    }
+
+    std::uint32_t GetCell(VertexId vertex) const {
+        return vertex_cells_[vertex];
+    }
+
+    const std::vector<std::uint32_t>& GetVertexCells() const {
+        return vertex_cells_;
+    }
+
+    size_t GetCellSize(std::uint32_t cell) const {
+        return vertex_offsets_[cell + 1] - vertex_offsets_[cell];
+    }
+
+    VertexId GetVertex(std::uint32_t cell, size_t local_id) const {
+        return vertices_[vertex_offsets_[cell] + local_id];
+    }
+
+    // Место вершины среди вершин её ячейки
+    size_t GetLocalId(VertexId vertex) const {
+        return local_ids_[vertex];
+    }
+
+    size_t GetBoundarySize(std::uint32_t cell) const {
+        return boundary_offsets_[cell + 1] - boundary_offsets_[cell];
+    }
+
+    VertexId GetBoundaryVertex(std::uint32_t cell, size_t boundary_id) const {
+        return boundary_vertices_[boundary_offsets_[cell] + boundary_id];
+    }
+
+    // Место вершины среди граничных вершин её ячейки или NO_BOUNDARY_ID
+    std::uint32_t GetBoundaryId(VertexId vertex) const {
+        return boundary_ids_[vertex];
+    }
+
+    size_t GetBoundaryVertexCount() const {
+        return boundary_vertices_.size();
+    }
+
+    // Первый переход ячейки; строки её матрицы идут подряд
+    size_t GetShortcutOffset(std::uint32_t cell) const {
+        return shortcut_offsets_[cell];
+    }
+
+    size_t GetShortcutCount() const {
+        return shortcut_offsets_.back();
+    }
+
+private:
+    std::vector<std::uint32_t> vertex_cells_;
+    std::vector<std::uint32_t> local_ids_;
+    std::vector<std::uint32_t> boundary_ids_;
+    // Вершины и граничные вершины по ячейкам
+    std::vector<VertexId> vertices_;
+    std::vector<size_t> vertex_offsets_;
+    std::vector<VertexId> boundary_vertices_;
+    std::vector<size_t> boundary_offsets_;
+    std::vector<size_t> shortcut_offsets_;
+};
+
+template <typename Weight>
+GraphPartition::GraphPartition(const DirectedWeightedGraph<Weight>& graph, std::vector<std::uint32_t> vertex_cells)
+    : vertex_cells_(std::move(vertex_cells))
+    , local_ids_(vertex_cells_.size())
+    , boundary_ids_(vertex_cells_.size(), NO_BOUNDARY_ID)
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    if (vertex_cells_.size() != vertex_count) {
+        throw std::invalid_argument("Partition should assign a cell to every vertex");
+    }
+    const size_t cell_count = vertex_cells_.empty()
+        ? 0
+        : *std::max_element(vertex_cells_.begin(), vertex_cells_.end()) + size_t{ 1 };
+
+    std::vector<char> is_boundary(vertex_count, false);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (vertex_cells_[edge.from] != vertex_cells_[edge.to]) {
+            is_boundary[edge.from] = true;
+            is_boundary[edge.to] = true;
+        }
+    }
+
+    vertex_offsets_.assign(cell_count + 1, 0);
+    boundary_offsets_.assign(cell_count + 1, 0);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        ++vertex_offsets_[vertex_cells_[vertex] + 1];
+        if (is_boundary[vertex]) {
+            ++boundary_offsets_[vertex_cells_[vertex] + 1];
+        }
+    }
+    for (size_t cell = 0; cell < cell_count; ++cell) {
+        vertex_offsets_[cell + 1] += vertex_offsets_[cell];
+        boundary_offsets_[cell + 1] += boundary_offsets_[cell];
+    }
+
+    vertices_.resize(vertex_count);
+    boundary_vertices_.resize(boundary_offsets_.back());
+    std::vector<size_t> cell_sizes(cell_count, 0);
+    std::vector<size_t> boundary_sizes(cell_count, 0);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        const std::uint32_t cell = vertex_cells_[vertex];
+        local_ids_[vertex] = static_cast<std::uint32_t>(cell_sizes[cell]);
+        vertices_[vertex_offsets_[cell] + cell_sizes[cell]++] = vertex;
+        if (is_boundary[vertex]) {
+            boundary_ids_[vertex] = static_cast<std::uint32_t>(boundary_sizes[cell]);
+            boundary_vertices_[boundary_offsets_[cell] + boundary_sizes[cell]++] = vertex;
+        }
+    }
+
+    shortcut_offsets_.assign(cell_count + 1, 0);
+    for (size_t cell = 0; cell < cell_count; ++cell) {
+        shortcut_offsets_[cell + 1] = shortcut_offsets_[cell] + boundary_sizes[cell] * boundary_sizes[cell];
+    }
+}
+
+// Переходы между граничными вершинами каждой ячейки по её внутренним рёбрам.
+// Массив весов может лежать в отображённом в память файле базы: страницы
+// ячейки читаются с диска, только когда поиск до неё доходит
+template <typename Weight>
+class OverlayShortcuts {
+public:
+    OverlayShortcuts(const Weight* weights, std::shared_ptr<const GraphPartition> partition,
+        std::shared_ptr<const void> storage)
+        : weights_(weights)
+        , partition_(std::move(partition))
+        , storage_(std::move(storage)) {
+    }
+
+    const GraphPartition& GetPartition() const {
+        return *partition_;
+    }
+
+    std::shared_ptr<const GraphPartition> GetSharedPartition() const {
+        return partition_;
+    }
+
+    // Строка переходов из граничной вершины boundary_id ячейки cell
+    const Weight* GetRow(std::uint32_t cell, size_t boundary_id) const {
+        return weights_ + partition_->GetShortcutOffset(cell) + boundary_id * partition_->GetBoundarySize(cell);
+    }
+
+    const Weight* GetWeights() const {
+        return weights_;
+    }
+
+private:
+    const Weight* weights_;
+    std::shared_ptr<const GraphPartition> partition_;
+    std::shared_ptr<const void> storage_;
+};
+
+// Многоуровневый Дейкстра с одним уровнем ячеек. Поиск идёт по исходным
+// рёбрам только в ячейках from и to, а остальные ячейки проходит переходами
+// между их граничными вершинами. Переходы найденного маршрута
+// разворачиваются в рёбра поиском внутри ячейки
+template <typename Weight>
+class OverlayRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    static constexpr Weight NO_SHORTCUT = std::numeric_limits<Weight>::has_infinity
+        ? std::numeric_limits<Weight>::infinity()
+        : std::numeric_limits<Weight>::max();
+
+    OverlayRouter(const Graph& graph, OverlayShortcuts<Weight> shortcuts);
+
+    // Считает переходы всех ячеек, ячейки обрабатываются параллельно
+    static OverlayShortcuts<Weight> ComputeShortcuts(const Graph& graph,
+        std::shared_ptr<const GraphPartition> partition);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override {
+        NullSearchMonitor monitor;
+        return Search(from, to, monitor);
+    }
+
+    std::optional<RouteInfo> BuildMonitoredRoute(VertexId from, VertexId to, SearchMonitor& monitor) const override {
+        return Search(from, to, monitor);
+    }
+
+    const OverlayShortcuts<Weight>& GetShortcuts() const {
+        return shortcuts_;
+    }
+
+    // Суммарное число вершин, просмотренных всеми запросами
+    size_t GetSettledVertexCount() const {
+        return settled_vertex_count_.load(std::memory_order_relaxed);
+    }
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    // Поиск внутри одной ячейки в её локальной нумерации
+    struct CellSearch {
+        std::vector<std::optional<Weight>> distances;
+        std::vector<std::optional<EdgeId>> prev_edges;
+        std::vector<QueueItem> queue;
+    };
+
+    // Буферы поиска по ячейкам и переходам; переход в вершину записан как
+    // предыдущая вершина без ребра
+    struct SearchBuffers {
+        std::vector<std::optional<Weight>> distances;
+        std::vector<std::optional<EdgeId>> prev_edges;
+        std::vector<VertexId> prev_vertices;
+        std::vector<VertexId> touched_vertices;
+        std::vector<QueueItem> queue;
+    };
+
+    static SearchBuffers& GetSearchBuffers(size_t vertex_count) {
+        static thread_local SearchBuffers buffers;
+        if (buffers.distances.size() < vertex_count) {
+            buffers.distances.resize(vertex_count);
+            buffers.prev_edges.resize(vertex_count);
+            buffers.prev_vertices.resize(vertex_count);
+        }
+        return buffers;
+    }
+
+    // Дейкстра от from по рёбрам внутри его ячейки; останавливается на to, если он задан
+    static void SearchCell(const Graph& graph, const GraphPartition& partition, VertexId from,
+        std::optional<VertexId> to, CellSearch& search);
+
+    // Рёбра кратчайшего пути from -> to внутри их общей ячейки
+    void AppendCellPath(VertexId from, VertexId to, std::vector<EdgeId>& edges) const;
+
+    template <typename Monitor>
+    std::optional<RouteInfo> Search(VertexId from, VertexId to, Monitor& monitor) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    OverlayShortcuts<Weight> shortcuts_;
+    mutable std::atomic<size_t> settled_vertex_count_{ 0 };
+};
+
+template <typename Weight>
+OverlayRouter<Weight>::OverlayRouter(const Graph& graph, OverlayShortcuts<Weight> shortcuts)
+    : graph_(graph)
+    , shortcuts_(std::move(shortcuts))
+{
+    if (!graph.IsFrozen()) {
+        throw std::invalid_argument("Graph should be frozen");
+    }
+    if (shortcuts_.GetPartition().GetVertexCount() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Partition doesn't match the graph");
+    }
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+OverlayShortcuts<Weight> OverlayRouter<Weight>::ComputeShortcuts(const Graph& graph,
+    std::shared_ptr<const GraphPartition> partition) {
+    auto weights = std::make_shared<std::vector<Weight>>(partition->GetShortcutCount(), NO_SHORTCUT);
+
+    std::atomic<size_t> next_cell{ 0 };
+    const auto compute_cells = [&graph, &partition, &weights, &next_cell]() {
+        CellSearch search;
+        for (size_t cell = next_cell++; cell < partition->GetCellCount(); cell = next_cell++) {
+            const auto cell_id = static_cast<std::uint32_t>(cell);
+            const size_t boundary_size = partition->GetBoundarySize(cell_id);
+            Weight* row = weights->data() + partition->GetShortcutOffset(cell_id);
+            for (size_t from = 0; from < boundary_size; ++from, row += boundary_size) {
+                SearchCell(graph, *partition, partition->GetBoundaryVertex(cell_id, from), std::nullopt, search);
+                for (size_t to = 0; to < boundary_size; ++to) {
+                    const auto& distance = search.distances[partition->GetLocalId(
+                        partition->GetBoundaryVertex(cell_id, to))];
+                    if (distance) {
+                        row[to] = *distance;
+                    }
+                }
+            }
+        }
+    };
+    const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+        partition->GetCellCount());
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < thread_count; ++i) {
+        workers.push_back(std::async(std::launch::async, compute_cells));
+    }
+    compute_cells();
+    for (auto& worker : workers) {
+        worker.get();
+    }
+
+    const Weight* data = weights->data();
+    return { data, std::move(partition), std::move(weights) };
+}
+
+template <typename Weight>
+void OverlayRouter<Weight>::SearchCell(const Graph& graph, const GraphPartition& partition, VertexId from,
+    std::optional<VertexId> to, CellSearch& search) {
+    const std::uint32_t cell = partition.GetCell(from);
+    const size_t cell_size = partition.GetCellSize(cell);
+    search.distances.assign(cell_size, std::nullopt);
+    search.prev_edges.assign(cell_size, std::nullopt);
+    search.queue.clear();
+    const auto queue_compare = std::greater<QueueItem>{};
+
+    search.distances[partition.GetLocalId(from)] = ZERO_WEIGHT;
+    search.queue.push_back({ ZERO_WEIGHT, from });
+    while (!search.queue.empty()) {
+        std::pop_heap(search.queue.begin(), search.queue.end(), queue_compare);
+        const auto [weight, vertex] = search.queue.back();
+        search.queue.pop_back();
+        if (*search.distances[partition.GetLocalId(vertex)] < weight) {
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+        for (const auto edge : graph.GetOutgoingEdges(vertex)) {
+            if (partition.GetCell(edge.to) != cell) {
+                continue;
+            }
+            const Weight candidate_weight = weight + edge.weight;
+            auto& distance = search.distances[partition.GetLocalId(edge.to)];
+            if (!distance || candidate_weight < *distance) {
+                distance = candidate_weight;
+                search.prev_edges[partition.GetLocalId(edge.to)] = edge.id;
+                search.queue.push_back({ candidate_weight, edge.to });
+                std::push_heap(search.queue.begin(), search.queue.end(), queue_compare);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void OverlayRouter<Weight>::AppendCellPath(VertexId from, VertexId to, std::vector<EdgeId>& edges) const {
+    const GraphPartition& partition = shortcuts_.GetPartition();
+    static thread_local CellSearch search;
+    SearchCell(graph_, partition, from, to, search);
+    const size_t first_edge = edges.size();
+    for (std::optional<EdgeId> edge_id = search.prev_edges[partition.GetLocalId(to)];
+        edge_id;
+        edge_id = search.prev_edges[partition.GetLocalId(graph_.GetEdge(*edge_id).from)])
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin() + first_edge, edges.end());
+}
+
+// Если monitor прервал поиск, маршрута нет
+template <typename Weight>
+template <typename Monitor>
+std::optional<typename OverlayRouter<Weight>::RouteInfo> OverlayRouter<Weight>::Search(VertexId from, VertexId to,
+    Monitor& monitor) const {
+    if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const GraphPartition& partition = shortcuts_.GetPartition();
+    const std::uint32_t from_cell = partition.GetCell(from);
+    const std::uint32_t to_cell = partition.GetCell(to);
+
+    SearchBuffers& buffers = GetSearchBuffers(graph_.GetVertexCount());
+    auto& distances = buffers.distances;
+    auto& prev_edges = buffers.prev_edges;
+    auto& prev_vertices = buffers.prev_vertices;
+    auto& queue = buffers.queue;
+    const auto queue_compare = std::greater<QueueItem>{};
+
+    distances[from] = ZERO_WEIGHT;
+    buffers.touched_vertices.push_back(from);
+    queue.push_back({ ZERO_WEIGHT, from });
+    monitor.OnPush();
+    size_t settled_count = 0;
+
+    const auto relax = [&](VertexId vertex, VertexId next, Weight candidate_weight, std::optional<EdgeId> edge_id) {
+        monitor.OnRelax();
+        auto& distance = distances[next];
+        if (!distance || candidate_weight < *distance) {
+            if (!distance) {
+                buffers.touched_vertices.push_back(next);
+            }
+            distance = candidate_weight;
+            prev_edges[next] = edge_id;
+            prev_vertices[next] = vertex;
+            queue.push_back({ candidate_weight, next });
+            std::push_heap(queue.begin(), queue.end(), queue_compare);
+            monitor.OnPush();
+        }
+    };
+
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), queue_compare);
+        const auto [weight, vertex] = queue.back();
+        queue.pop_back();
+        monitor.OnPop();
+
+        if (*distances[vertex] < weight) {
+            continue;
+        }
+        ++settled_count;
+        monitor.OnSettle();
+        if (vertex == to || monitor.IsExpired()) {
+            break;
+        }
+
+        // В чужие ячейки поиск попадает только через граничные вершины и
+        // проходит их по переходам, наружу выходит по рёбрам между ячейками.
+        // Переходы нужны только из вершины входа в ячейку: переход дальше из
+        // вершины, в которую пришли переходом, не короче прямого перехода
+        const std::uint32_t cell = partition.GetCell(vertex);
+        const bool is_local_cell = cell == from_cell || cell == to_cell;
+        for (const auto edge : graph_.GetOutgoingEdges(vertex)) {
+            if (is_local_cell || partition.GetCell(edge.to) != cell) {
+                relax(vertex, edge.to, weight + edge.weight, edge.id);
+            }
+        }
+        if (!is_local_cell && prev_edges[vertex]) {
+            const std::uint32_t boundary_id = partition.GetBoundaryId(vertex);
+            const Weight* row = shortcuts_.GetRow(cell, boundary_id);
+            for (size_t next = 0; next < partition.GetBoundarySize(cell); ++next) {
+                if (next != boundary_id && row[next] != NO_SHORTCUT) {
+                    relax(vertex, partition.GetBoundaryVertex(cell, next), weight + row[next], std::nullopt);
+                }
+            }
+        }
+    }
+    settled_vertex_count_.fetch_add(settled_count, std::memory_order_relaxed);
+
+    std::optional<RouteInfo> route;
+    if (distances[to] && !monitor.IsExpired()) {
+        // Вершины маршрута от to к from: переход отмечен вершиной без ребра
+        std::vector<std::pair<VertexId, std::optional<EdgeId>>> steps;
+        for (VertexId vertex = to; vertex != from; vertex = prev_vertices[vertex]) {
+            steps.emplace_back(vertex, prev_edges[vertex]);
+        }
+        std::vector<EdgeId> edges;
+        for (auto it = steps.rbegin(); it != steps.rend(); ++it) {
+            const auto& [vertex, edge_id] = *it;
+            if (edge_id) {
+                edges.push_back(*edge_id);
+            } else {
+                AppendCellPath(prev_vertices[vertex], vertex, edges);
+            }
+        }
+        // Вес по рёбрам в порядке маршрута, как у поиска по исходному графу
+        Weight route_weight = ZERO_WEIGHT;
+        for (const EdgeId edge_id : edges) {
+            route_weight += graph_.GetEdge(edge_id).weight;
+        }
+        route = RouteInfo{ route_weight, std::move(edges) };
+    }
+
+    for (const VertexId vertex : buffers.touched_vertices) {
+        distances[vertex].reset();
+        prev_edges[vertex].reset();
+    }
+    buffers.touched_vertices.clear();
+    queue.clear();
+    return route;
+}
+
+}  // namespace graph
@@ -0,0 +1,265 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+namespace transport_router {
+
+    RaptorRouter::RaptorRouter(
+            const transport_catalogue::TransportCatalogue &transport_catalogue,
+            const vector<const domain::Stop *> &stops,
+            const vector<const domain::Bus *> &buses,
+            double bus_wait_time,
+            double bus_velocity
+    ) : timing_{bus_wait_time, bus_velocity} {
+        unordered_map<const domain::Stop *, StopId> stop_ids;
+        for (StopId stop_id = 0; stop_id < stops.size(); ++stop_id) {
+            stop_ids[stops[stop_id]] = stop_id;
+        }
+
+        for (BusId bus_id = 0; bus_id < buses.size(); ++bus_id) {
+            const domain::Bus *bus = buses[bus_id];
+            const auto &route = bus->bus_route_;
+            const size_t stops_count = route.size();
+            if (stops_count < 2) {
+                continue;
+            }
+
+            vector<StopId> route_stops(stops_count);
+            vector<int> distances(stops_count, 0);
+            vector<int> back_distances(stops_count, 0);
+            for (size_t k = 0; k < stops_count; ++k) {
+                route_stops[k] = stop_ids.at(route[k]);
+                if (k > 0) {
+                    distances[k] = distances[k - 1] + transport_catalogue.GetDistance(route[k - 1], route[k]);
+                    back_distances[k] = back_distances[k - 1] + transport_catalogue.GetDistance(route[k], route[k - 1]);
+                }
+            }
+            AddPattern(bus_id, route_stops, distances);
+
+            // Обратный проход некольцевого маршрута: расстояния считаются от
+            // его последней остановки, разности те же, что у рёбер графа
+            if (!bus->is_roundtrip_) {
+                reverse(route_stops.begin(), route_stops.end());
+                for (size_t k = 0; k < stops_count; ++k) {
+                    distances[k] = back_distances[stops_count - 1] - back_distances[stops_count - 1 - k];
+                }
+                AddPattern(bus_id, route_stops, distances);
+            }
+        }
+
+        stop_pattern_offsets_.assign(stops.size() + 1, 0);
+        for (const StopId stop: pattern_stops_) {
+            ++stop_pattern_offsets_[stop + 1];
+        }
+        for (size_t i = 1; i < stop_pattern_offsets_.size(); ++i) {
+            stop_pattern_offsets_[i] += stop_pattern_offsets_[i - 1];
+        }
+        stop_patterns_.resize(pattern_stops_.size());
+        vector<size_t> next_slots(stop_pattern_offsets_.begin(), stop_pattern_offsets_.end() - 1);
+        for (uint32_t pattern_id = 0; pattern_id < patterns_.size(); ++pattern_id) {
+            const Pattern &pattern = patterns_[pattern_id];
+            for (uint32_t position = 0; position < pattern.stop_count; ++position) {
+                const StopId stop = pattern_stops_[pattern.first + position];
+                stop_patterns_[next_slots[stop]++] = {pattern_id, position};
+            }
+        }
+    }
+
+    void RaptorRouter::AddPattern(BusId bus_id, const vector<StopId> &stops, const vector<int> &distances) {
+        patterns_.push_back({bus_id, static_cast<uint32_t>(pattern_stops_.size()), static_cast<uint32_t>(stops.size())});
+        pattern_stops_.insert(pattern_stops_.end(), stops.begin(), stops.end());
+        pattern_distances_.insert(pattern_distances_.end(), distances.begin(), distances.end());
+    }
+
+    RaptorRouter::SearchBuffers &RaptorRouter::GetSearchBuffers(size_t stop_count, size_t pattern_count) {
+        static thread_local SearchBuffers buffers;
+        if (buffers.arrivals.size() < stop_count) {
+            buffers.arrivals.resize(stop_count);
+            buffers.parents.resize(stop_count);
+            buffers.marked.resize(stop_count, false);
+        }
+        if (buffers.first_positions.size() < pattern_count) {
+            buffers.first_positions.resize(pattern_count, NO_POSITION);
+        }
+        return buffers;
+    }
+
+    void RaptorRouter::ResetSearchBuffers(SearchBuffers &buffers) {
+        for (const StopId stop: buffers.touched_stops) {
+            buffers.arrivals[stop].reset();
+        }
+        buffers.touched_stops.clear();
+    }
+
+    optional<RaptorRouter::Journey> RaptorRouter::BuildRoute(StopId from, StopId to) const {
+        return BuildRoute(from, to, timing_.bus_wait_time, timing_.bus_velocity);
+    }
+
+    optional<RaptorRouter::Journey> RaptorRouter::BuildRoute(
+            StopId from,
+            StopId to,
+            double bus_wait_time,
+            double bus_velocity
+    ) const {
+        const Timing timing{bus_wait_time, bus_velocity};
+        const size_t stop_count = stop_pattern_offsets_.size() - 1;
+        if (from >= stop_count || to >= stop_count) {
+            throw out_of_range("Stop id is out of range");
+        }
+        SearchBuffers &buffers = GetSearchBuffers(stop_count, patterns_.size());
+        RunRounds(from, to, numeric_limits<double>::infinity(), timing, buffers);
+
+        optional<Journey> journey;
+        if (buffers.arrivals[to]) {
+            vector<Leg> legs;
+            for (StopId stop = to; stop != from;) {
+                const ParentLeg &parent = buffers.parents[stop];
+                const Pattern &pattern = patterns_[parent.pattern];
+                const StopId board_stop = pattern_stops_[pattern.first + parent.board];
+                legs.push_back(
+                        {
+                                pattern.bus_id,
+                                board_stop,
+                                stop,
+                                static_cast<size_t>(parent.alight - parent.board),
+                                GetRideTime(pattern, parent.board, parent.alight, timing.bus_velocity)
+                        }
+                );
+                stop = board_stop;
+            }
+            reverse(legs.begin(), legs.end());
+            journey = Journey{*buffers.arrivals[to], move(legs)};
+        }
+
+        ResetSearchBuffers(buffers);
+        return journey;
+    }
+
+    vector<pair<RaptorRouter::StopId, double>> RaptorRouter::BuildReachable(StopId from, double max_time) const {
+        const size_t stop_count = stop_pattern_offsets_.size() - 1;
+        if (from >= stop_count) {
+            throw out_of_range("Stop id is out of range");
+        }
+        vector<pair<StopId, double>> reachable;
+        if (max_time < 0) {
+            return reachable;
+        }
+        SearchBuffers &buffers = GetSearchBuffers(stop_count, patterns_.size());
+        RunRounds(from, nullopt, max_time, timing_, buffers);
+
+        reachable.reserve(buffers.touched_stops.size());
+        for (const StopId stop: buffers.touched_stops) {
+            reachable.push_back({stop, *buffers.arrivals[stop]});
+        }
+        sort(reachable.begin(), reachable.end(), [](const auto &lhs, const auto &rhs) {
+            return lhs.second < rhs.second;
+        });
+
+        ResetSearchBuffers(buffers);
+        return reachable;
+    }
+
+    void RaptorRouter::RunRounds(
+            StopId from,
+            optional<StopId> to,
+            double max_time,
+            const Timing &timing,
+            SearchBuffers &buffers
+    ) const {
+        buffers.arrivals[from] = 0.0;
+        buffers.touched_stops.push_back(from);
+        buffers.marked_stops.push_back(from);
+
+        // Раунд k находит пути из k поездок. Остановки, улучшенные в раунде,
+        // становятся точками посадки следующего
+        while (!buffers.marked_stops.empty()) {
+            for (const StopId stop: buffers.marked_stops) {
+                buffers.marked[stop] = false;
+                for (size_t i = stop_pattern_offsets_[stop]; i < stop_pattern_offsets_[stop + 1]; ++i) {
+                    const auto [pattern_id, position] = stop_patterns_[i];
+                    uint32_t &first_position = buffers.first_positions[pattern_id];
+                    if (first_position == NO_POSITION) {
+                        buffers.queued_patterns.push_back(pattern_id);
+                    }
+                    first_position = min(first_position, position);
+                }
+            }
+            buffers.marked_stops.clear();
+
+            for (const uint32_t pattern_id: buffers.queued_patterns) {
+                ScanPattern(pattern_id, to, max_time, timing, buffers);
+            }
+            buffers.queued_patterns.clear();
+        }
+    }
+
+    // Садиться выгоднее там, где меньше прибытие минус время проезда от
+    // начала прохода: это не зависит от остановки высадки. Время до высадки
+    // считается в том же порядке, что и сумма рёбер графа
+    void RaptorRouter::ScanPattern(
+            uint32_t pattern_id,
+            optional<StopId> to,
+            double max_time,
+            const Timing &timing,
+            SearchBuffers &buffers
+    ) const {
+        const Pattern &pattern = patterns_[pattern_id];
+        const StopId *stops = pattern_stops_.data() + pattern.first;
+        auto &arrivals = buffers.arrivals;
+
+        uint32_t board = NO_POSITION;
+        double board_key = 0;
+        for (uint32_t position = buffers.first_positions[pattern_id]; position < pattern.stop_count; ++position) {
+            const StopId stop = stops[position];
+            if (board != NO_POSITION) {
+                const double candidate = (*arrivals[stops[board]] + timing.bus_wait_time)
+                                         + GetRideTime(pattern, board, position, timing.bus_velocity);
+                // Остановки не лучше уже найденного пути до цели не улучшают ответ
+                if ((!arrivals[stop] || candidate < *arrivals[stop])
+                    && (!to || !arrivals[*to] || candidate < *arrivals[*to])
+                    && !(max_time < candidate)) {
+                    if (!arrivals[stop]) {
+                        buffers.touched_stops.push_back(stop);
+                    }
+                    arrivals[stop] = candidate;
+                    buffers.parents[stop] = {pattern_id, board, position};
+                    if (stop != to && !buffers.marked[stop]) {
+                        buffers.marked[stop] = true;
+                        buffers.marked_stops.push_back(stop);
+                    }
+                }
+            }
+            if (arrivals[stop]) {
+                const double key = *arrivals[stop] - pattern_distances_[pattern.first + position] / timing.bus_velocity;
+                if (board == NO_POSITION || key < board_key) {
+                    board = position;
+                    board_key = key;
+                }
+            }
+        }
+        buffers.first_positions[pattern_id] = NO_POSITION;
+    }
+
+    double RaptorRouter::GetRideTime(
+            const Pattern &pattern,
+            uint32_t board,
+            uint32_t alight,
+            double bus_velocity
+    ) const {
+        return (pattern_distances_[pattern.first + alight] - pattern_distances_[pattern.first + board]) / bus_velocity;
+    }
+
+    size_t RaptorRouter::GetPatternCount() const {
+        return patterns_.size();
+    }
+
+    size_t RaptorRouter::GetIndexBytes() const {
+        return patterns_.size() * sizeof(Pattern)
+               + pattern_stops_.size() * (sizeof(StopId) + sizeof(int) + sizeof(PatternStop))
+               + stop_pattern_offsets_.size() * sizeof(size_t);
+    }
+}
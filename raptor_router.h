@@ -0,0 +1,137 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace transport_router {
+    // Поиск по раундам в духе RAPTOR прямо по маршрутам автобусов: каждый
+    // раунд просматривает проходы автобусов через остановки, улучшенные в
+    // прошлом раунде. Граф с ребром на каждую пару остановок маршрута не
+    // нужен, индекс линеен по суммарной длине маршрутов
+    class RaptorRouter {
+    public:
+        using StopId = std::uint32_t;
+        using BusId = std::uint32_t;
+
+        // Поездка: ожидание на остановке посадки и проезд span_count пролётов
+        struct Leg {
+            BusId bus_id;
+            StopId board_stop;
+            StopId alight_stop;
+            size_t span_count;
+            double ride_time;
+        };
+
+        struct Journey {
+            double total_time;
+            std::vector<Leg> legs;
+        };
+
+        // stops и buses задают id остановок и автобусов, bus_velocity - в метрах в минуту
+        RaptorRouter(
+                const transport_catalogue::TransportCatalogue &transport_catalogue,
+                const std::vector<const domain::Stop *> &stops,
+                const std::vector<const domain::Bus *> &buses,
+                double bus_wait_time,
+                double bus_velocity
+        );
+
+        std::optional<Journey> BuildRoute(StopId from, StopId to) const;
+
+        // Маршрут при других времени ожидания и скорости, индекс тот же
+        std::optional<Journey> BuildRoute(StopId from, StopId to, double bus_wait_time, double bus_velocity) const;
+
+        // Все остановки, куда можно доехать из from не дольше чем за max_time,
+        // со временем прибытия, по возрастанию времени
+        std::vector<std::pair<StopId, double>> BuildReachable(StopId from, double max_time) const;
+
+        size_t GetPatternCount() const;
+
+        size_t GetIndexBytes() const;
+
+    private:
+        static constexpr std::uint32_t NO_POSITION = std::numeric_limits<std::uint32_t>::max();
+
+        // Проход автобуса в одну сторону. Его остановки и расстояния от начала
+        // прохода лежат в общих массивах начиная с first
+        struct Pattern {
+            BusId bus_id;
+            std::uint32_t first;
+            std::uint32_t stop_count;
+        };
+
+        struct PatternStop {
+            std::uint32_t pattern;
+            std::uint32_t position;
+        };
+
+        // Поездка, которой достигнута остановка: проход и позиции посадки и высадки
+        struct ParentLeg {
+            std::uint32_t pattern;
+            std::uint32_t board;
+            std::uint32_t alight;
+        };
+
+        struct Timing {
+            double bus_wait_time;
+            double bus_velocity;
+        };
+
+        // Буферы переиспользуются всеми запросами одного потока; после запроса
+        // сбрасываются только затронутые остановки
+        struct SearchBuffers {
+            std::vector<std::optional<double>> arrivals;
+            std::vector<ParentLeg> parents;
+            std::vector<char> marked;
+            std::vector<StopId> marked_stops;
+            std::vector<StopId> touched_stops;
+            std::vector<std::uint32_t> first_positions;
+            std::vector<std::uint32_t> queued_patterns;
+        };
+
+        static SearchBuffers &GetSearchBuffers(size_t stop_count, size_t pattern_count);
+
+        static void ResetSearchBuffers(SearchBuffers &buffers);
+
+        void AddPattern(BusId bus_id, const std::vector<StopId> &stops, const std::vector<int> &distances);
+
+        // Раунды поиска от from. Если задана цель to, прибытия не хуже уже
+        // найденного до неё отбрасываются, прибытия позже max_time - всегда
+        void RunRounds(
+                StopId from,
+                std::optional<StopId> to,
+                double max_time,
+                const Timing &timing,
+                SearchBuffers &buffers
+        ) const;
+
+        void ScanPattern(
+                std::uint32_t pattern_id,
+                std::optional<StopId> to,
+                double max_time,
+                const Timing &timing,
+                SearchBuffers &buffers
+        ) const;
+
+        double GetRideTime(
+                const Pattern &pattern,
+                std::uint32_t board,
+                std::uint32_t alight,
+                double bus_velocity
+        ) const;
+
+        Timing timing_;
+        std::vector<Pattern> patterns_;
+        std::vector<StopId> pattern_stops_;
+        std::vector<int> pattern_distances_;
+        // Для каждой остановки - проходы через неё и её позиции в них
+        std::vector<size_t> stop_pattern_offsets_;
+        std::vector<PatternStop> stop_patterns_;
+    };
+}
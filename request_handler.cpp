@@ -68,10 +68,97 @@ namespace request_handler {
         return node;
     }
 
-    Node RequestHandler::RouterHandler(int request_id, string_view start_stop, string_view final_stop) {
-        Node node;
+    Node RequestHandler::RouterHandler(
+            int request_id,
+            string_view start_stop,
+            string_view final_stop,
+            const vector<string_view> &via,
+            const transport_router::TransportRouter::RouteOverrides &overrides,
+            const RouteSearchOptions &search_options
+    ) {
+        vector<string_view> waypoints;
+        waypoints.reserve(via.size() + 2);
+        waypoints.push_back(start_stop);
+        waypoints.insert(waypoints.end(), via.begin(), via.end());
+        waypoints.push_back(final_stop);
+
+        if (!search_options.explain && !search_options.deadline) {
+            if (via.empty()) {
+                return RouteNode(request_id, router_.FindRoute(start_stop, final_stop, overrides).get());
+            }
+            return RouteNode(request_id, JoinRouteLegs(router_.FindRouteLegs(waypoints, overrides)).get());
+        }
+
+        // Участки ищутся по очереди под одним monitor: срок и счётчики общие
+        // на весь маршрут
+        graph::SearchMonitor monitor(search_options.deadline);
+        vector<shared_ptr<const transport_router::TransportRouter::Route>> legs;
+        legs.reserve(waypoints.size() - 1);
+        for (size_t i = 0; i + 1 < waypoints.size() && !monitor.IsExpired(); ++i) {
+            legs.push_back(router_.FindRoute(waypoints[i], waypoints[i + 1], overrides, monitor));
+        }
+        const auto route = JoinRouteLegs(legs);
+        const double wall_time_us = chrono::duration<double, micro>(monitor.GetElapsedTime()).count();
+
+        Node node = monitor.IsExpired()
+                    ? Builder{}
+                            .StartDict()
+                            .Key("request_id"s).Value(request_id)
+                            .Key("error_message"s).Value("timeout"s)
+                            .EndDict()
+                            .Build()
+                    : RouteNode(request_id, route.get());
+        if (!search_options.explain) {
+            return node;
+        }
+
+        const graph::SearchStats &stats = monitor.GetStats();
+        Dict response = node.AsMap();
+        response["explain"s] = Builder{}
+                .StartDict()
+                .Key("settled_vertices"s).Value(static_cast<int>(stats.settled_vertices))
+                .Key("relaxed_edges"s).Value(static_cast<int>(stats.relaxed_edges))
+                .Key("heap_pushes"s).Value(static_cast<int>(stats.heap_pushes))
+                .Key("heap_pops"s).Value(static_cast<int>(stats.heap_pops))
+                .Key("wall_time_us"s).Value(wall_time_us)
+                .EndDict()
+                .Build();
+        return Node{std::move(response)};
+    }
+
+    vector<Node> RequestHandler::RouteBatchHandler(
+            const vector<int> &request_ids,
+            string_view start_stop,
+            const vector<string_view> &final_stops
+    ) {
+        vector<Node> nodes;
+        nodes.reserve(request_ids.size());
+        const auto routes = router_.FindRoutes(start_stop, final_stops);
+        for (size_t i = 0; i < routes.size(); ++i) {
+            nodes.push_back(RouteNode(request_ids[i], routes[i].get()));
+        }
+        return nodes;
+    }
+
+    shared_ptr<const transport_router::TransportRouter::Route> RequestHandler::JoinRouteLegs(
+            const vector<shared_ptr<const transport_router::TransportRouter::Route>> &legs
+    ) {
+        if (legs.size() == 1) {
+            return legs.front();
+        }
+        auto route = make_shared<transport_router::TransportRouter::Route>();
+        for (const auto &leg: legs) {
+            if (!leg) {
+                return nullptr;
+            }
+            route->total_time += leg->total_time;
+            route->items.insert(route->items.end(), leg->items.begin(), leg->items.end());
+        }
+        return route;
+    }
 
-        const auto &route = router_.FindRoute(start_stop, final_stop);
+    Node RequestHandler::RouteNode(int request_id, const transport_router::TransportRouter::Route *route) const {
+        Node node;
 
         if (!route) {
             node = Builder{}
@@ -82,18 +169,16 @@ namespace request_handler {
                     .Build();
         } else {
             Array items;
-            items.reserve(route.value().edges.size());
+            items.reserve(route->items.size());
 
             double total_time = 0;
 
-            for (auto &edge_id: route.value().edges) {
-                const graph::Edge<double> edge = router_.GetGraphEdge(edge_id);
-
+            for (const auto &edge: route->items) {
                 Node item;
                 if (edge.quality == 0) {
                     item = Builder{}
                             .StartDict()
-                            .Key("stop_name"s).Value(edge.name)
+                            .Key("stop_name"s).Value(string(router_.GetEdgeName(edge)))
                             .Key("time"s).Value(edge.weight)
                             .Key("type"s).Value("Wait"s)
                             .EndDict()
@@ -102,7 +187,7 @@ namespace request_handler {
                 } else {
                     item = Builder{}
                             .StartDict()
-                            .Key("bus"s).Value(edge.name)
+                            .Key("bus"s).Value(string(router_.GetEdgeName(edge)))
                             .Key("span_count"s).Value(static_cast<int>(edge.quality))
                             .Key("time"s).Value(edge.weight)
                             .Key("type"s).Value("Bus"s)
@@ -124,4 +209,49 @@ namespace request_handler {
 
         return node;
     }
+
+    Node RequestHandler::ReachableHandler(int request_id, string_view start_stop, double max_time) {
+        Array items;
+        for (const auto &[stop, time]: router_.FindReachableStops(start_stop, max_time)) {
+            items.emplace_back(
+                    Builder{}
+                            .StartDict()
+                            .Key("stop_name"s).Value(stop->stop_name_)
+                            .Key("time"s).Value(time)
+                            .EndDict()
+                            .Build()
+            );
+        }
+
+        return Builder{}
+                .StartDict()
+                .Key("request_id"s).Value(request_id)
+                .Key("items"s).Value(items)
+                .EndDict()
+                .Build();
+    }
+
+    Node RequestHandler::MatrixHandler(
+            int request_id,
+            const vector<string_view> &sources,
+            const vector<string_view> &targets
+    ) {
+        Array rows;
+        rows.reserve(sources.size());
+        for (const auto &travel_times: router_.FindTravelTimes(sources, targets)) {
+            Array row;
+            row.reserve(travel_times.size());
+            for (const auto &time: travel_times) {
+                row.emplace_back(time ? Node{*time} : Node{nullptr});
+            }
+            rows.emplace_back(std::move(row));
+        }
+
+        return Builder{}
+                .StartDict()
+                .Key("request_id"s).Value(request_id)
+                .Key("times"s).Value(rows)
+                .EndDict()
+                .Build();
+    }
 } // namespace request_handler
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <optional>
 #include <string_view>
+#include <vector>
 
 #include "transport_catalogue.h"
 #include "transport_router.h"
@@ -13,11 +17,24 @@ namespace request_handler {
     using namespace json;
     using namespace domain;
 
+    // Отладка запроса Route: explain добавляет в ответ работу поиска, а
+    // поиск дольше deadline прерывается с ответом "timeout"
+    struct RouteSearchOptions {
+        bool explain = false;
+        std::optional<std::chrono::microseconds> deadline;
+    };
+
     class RequestHandler {
     private:
         transport_catalogue::TransportCatalogue &transport_catalogue_;
         renderer::MapRenderer &renderer_;
         transport_router::TransportRouter &router_;
+
+        Node RouteNode(int request_id, const transport_router::TransportRouter::Route *route) const;
+        // Маршрут через все участки подряд; пустой указатель, если нет хотя бы одного участка
+        static std::shared_ptr<const transport_router::TransportRouter::Route> JoinRouteLegs(
+                const std::vector<std::shared_ptr<const transport_router::TransportRouter::Route>> &legs
+        );
     public:
         RequestHandler(
                 transport_catalogue::TransportCatalogue &transport_catalogue,
@@ -31,7 +48,27 @@ namespace request_handler {
         Node MapRequestHandler(int request_id);
         Node StopRequestHandler(int request_id, std::string_view request_name);
         Node BusRequestHandler(int request_id, std::string_view request_name);
-        Node RouterHandler(int request_id, std::string_view start_stop, std::string_view final_stop);
+        // Маршрут от start_stop до final_stop через остановки via по порядку
+        Node RouterHandler(
+                int request_id,
+                std::string_view start_stop,
+                std::string_view final_stop,
+                const std::vector<std::string_view> &via = {},
+                const transport_router::TransportRouter::RouteOverrides &overrides = {},
+                const RouteSearchOptions &search_options = {}
+        );
+        // Ответы на запросы Route от одной остановки start_stop, в порядке final_stops
+        std::vector<Node> RouteBatchHandler(
+                const std::vector<int> &request_ids,
+                std::string_view start_stop,
+                const std::vector<std::string_view> &final_stops
+        );
+        Node ReachableHandler(int request_id, std::string_view start_stop, double max_time);
+        Node MatrixHandler(
+                int request_id,
+                const std::vector<std::string_view> &sources,
+                const std::vector<std::string_view> &targets
+        );
     };
 
 } // namespace request_handler
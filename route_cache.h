@@ -0,0 +1,110 @@
+#pragma once
+
+#include "graph.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace transport_router {
+    // Кэш маршрутов по паре вершин с вытеснением давно не запрошенных.
+    // Кэш разбит на сегменты со своими мьютексами, чтобы параллельные запросы
+    // реже ждали друг друга; вместимость делится между сегментами поровну
+    template <typename Value>
+    class RouteCache {
+    public:
+        explicit RouteCache(size_t capacity)
+                : shard_capacity_((capacity + SHARD_COUNT - 1) / SHARD_COUNT) {
+        }
+
+        std::optional<Value> Find(graph::VertexId from, graph::VertexId to) {
+            if (shard_capacity_ == 0) {
+                return std::nullopt;
+            }
+            const Key key = MakeKey(from, to);
+            Shard &shard = GetShard(key);
+            std::lock_guard guard(shard.mutex);
+            const auto it = shard.index.find(key);
+            if (it == shard.index.end()) {
+                misses_.fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            shard.items.splice(shard.items.begin(), shard.items, it->second);
+            return it->second->second;
+        }
+
+        void Insert(graph::VertexId from, graph::VertexId to, Value value) {
+            if (shard_capacity_ == 0) {
+                return;
+            }
+            const Key key = MakeKey(from, to);
+            Shard &shard = GetShard(key);
+            std::lock_guard guard(shard.mutex);
+            if (const auto it = shard.index.find(key); it != shard.index.end()) {
+                it->second->second = std::move(value);
+                shard.items.splice(shard.items.begin(), shard.items, it->second);
+                return;
+            }
+            if (shard.items.size() == shard_capacity_) {
+                shard.index.erase(shard.items.back().first);
+                shard.items.pop_back();
+            }
+            shard.items.emplace_front(key, std::move(value));
+            shard.index[key] = shard.items.begin();
+        }
+
+        void Clear() {
+            for (Shard &shard: shards_) {
+                std::lock_guard guard(shard.mutex);
+                shard.items.clear();
+                shard.index.clear();
+            }
+        }
+
+        size_t GetCapacity() const {
+            return shard_capacity_ * SHARD_COUNT;
+        }
+
+        size_t GetHitCount() const {
+            return hits_.load(std::memory_order_relaxed);
+        }
+
+        size_t GetMissCount() const {
+            return misses_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        static constexpr size_t SHARD_COUNT = 16;
+
+        using Key = std::uint64_t;
+
+        struct Shard {
+            std::mutex mutex;
+            std::list<std::pair<Key, Value>> items;
+            std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator> index;
+        };
+
+        static Key MakeKey(graph::VertexId from, graph::VertexId to) {
+            return (static_cast<Key>(from) << 32) | static_cast<std::uint32_t>(to);
+        }
+
+        Shard &GetShard(Key key) {
+            // Перемешивание битов, чтобы соседние пары попадали в разные сегменты
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdULL;
+            key ^= key >> 33;
+            return shards_[key % SHARD_COUNT];
+        }
+
+        size_t shard_capacity_;
+        std::array<Shard, SHARD_COUNT> shards_;
+        std::atomic<size_t> hits_{0};
+        std::atomic<size_t> misses_{0};
+    };
+}
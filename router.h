@@ -3,115 +3,718 @@
 #include "graph.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <cstdlib>
+#include <future>
 #include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <numeric>
 #include <optional>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 namespace graph {
 
 template <typename Weight>
-class Router {
+struct RouteInfo {
+    Weight weight;
+    std::vector<EdgeId> edges;
+};
+
+// Ячейка таблицы маршрутов. В самой таблице веса и последние рёбра лежат
+// в двух отдельных плоских массивах
+template <typename Weight>
+struct RoutesTableCell {
+    static constexpr std::uint32_t NO_ROUTE = UINT32_MAX;
+    static constexpr std::uint32_t NO_PREV_EDGE = UINT32_MAX - 1;
+
+    Weight weight;
+    std::uint32_t prev_edge;
+};
+
+// Слабо связные компоненты графа. Между вершинами разных компонент путей нет
+// ни в одну сторону, поэтому таблица всех пар хранится по компонентам: ячеек
+// в ней сумма квадратов их размеров вместо V^2. Компоненты нумеруются по
+// наименьшей вершине, вершины внутри компоненты идут по возрастанию
+class GraphComponents {
+public:
+    template <typename Weight>
+    explicit GraphComponents(const DirectedWeightedGraph<Weight>& graph);
+
+    size_t GetVertexCount() const {
+        return component_ids_.size();
+    }
+
+    size_t GetComponentCount() const {
+        return vertex_offsets_.size() - 1;
+    }
+
+    size_t GetComponent(VertexId vertex) const {
+        return component_ids_[vertex];
+    }
+
+    // Место вершины среди вершин её компоненты
+    size_t GetLocalId(VertexId vertex) const {
+        return local_ids_[vertex];
+    }
+
+    size_t GetComponentSize(size_t component) const {
+        return vertex_offsets_[component + 1] - vertex_offsets_[component];
+    }
+
+    VertexId GetVertex(size_t component, size_t local_id) const {
+        return vertices_[vertex_offsets_[component] + local_id];
+    }
+
+    // Первая ячейка таблицы компоненты; её строки идут подряд
+    size_t GetCellOffset(size_t component) const {
+        return cell_offsets_[component];
+    }
+
+    size_t GetCellCount() const {
+        return cell_offsets_.back();
+    }
+
+    // Ячейка маршрута from -> to, если вершины в одной компоненте
+    std::optional<size_t> GetCell(VertexId from, VertexId to) const {
+        const size_t component = component_ids_[from];
+        if (component != component_ids_[to]) {
+            return std::nullopt;
+        }
+        return cell_offsets_[component] + local_ids_[from] * GetComponentSize(component) + local_ids_[to];
+    }
+
+private:
+    std::vector<std::uint32_t> component_ids_;
+    std::vector<std::uint32_t> local_ids_;
+    // Вершины по компонентам
+    std::vector<VertexId> vertices_;
+    std::vector<size_t> vertex_offsets_;
+    std::vector<size_t> cell_offsets_;
+};
+
+template <typename Weight>
+GraphComponents::GraphComponents(const DirectedWeightedGraph<Weight>& graph)
+    : component_ids_(graph.GetVertexCount())
+    , local_ids_(graph.GetVertexCount())
+    , vertices_(graph.GetVertexCount())
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    // Корень каждого множества - его наименьшая вершина
+    std::vector<VertexId> parents(vertex_count);
+    std::iota(parents.begin(), parents.end(), VertexId{ 0 });
+    const auto find_root = [&parents](VertexId vertex) {
+        while (parents[vertex] != vertex) {
+            parents[vertex] = parents[parents[vertex]];
+            vertex = parents[vertex];
+        }
+        return vertex;
+    };
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        const VertexId from_root = find_root(edge.from);
+        const VertexId to_root = find_root(edge.to);
+        parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+    }
+
+    std::vector<size_t> component_sizes;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        const VertexId root = find_root(vertex);
+        if (root == vertex) {
+            component_ids_[vertex] = static_cast<std::uint32_t>(component_sizes.size());
+            component_sizes.push_back(0);
+        } else {
+            component_ids_[vertex] = component_ids_[root];
+        }
+        local_ids_[vertex] = static_cast<std::uint32_t>(component_sizes[component_ids_[vertex]]++);
+    }
+
+    vertex_offsets_.assign(1, 0);
+    cell_offsets_.assign(1, 0);
+    for (const size_t size : component_sizes) {
+        vertex_offsets_.push_back(vertex_offsets_.back() + size);
+        cell_offsets_.push_back(cell_offsets_.back() + size * size);
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        vertices_[vertex_offsets_[component_ids_[vertex]] + local_ids_[vertex]] = vertex;
+    }
+}
+
+// Готовая таблица всех пар: веса и последние рёбра построчно по компонентам.
+// Память таблицы не копируется: storage продлевает жизнь её владельца,
+// например отображённого в память файла базы
+template <typename Weight>
+class RoutesTable {
+public:
+    using Cell = RoutesTableCell<Weight>;
+
+    RoutesTable(const Weight* weights, const std::uint32_t* prev_edges,
+        std::shared_ptr<const GraphComponents> components, std::shared_ptr<const void> storage)
+        : weights_(weights)
+        , prev_edges_(prev_edges)
+        , components_(std::move(components))
+        , storage_(std::move(storage)) {
+    }
+
+    size_t GetVertexCount() const {
+        return components_->GetVertexCount();
+    }
+
+    const GraphComponents& GetComponents() const {
+        return *components_;
+    }
+
+    Cell GetCell(VertexId from, VertexId to) const {
+        const auto cell = components_->GetCell(from, to);
+        if (!cell) {
+            return { Weight{}, Cell::NO_ROUTE };
+        }
+        return { weights_[*cell], prev_edges_[*cell] };
+    }
+
+    const Weight* GetWeights() const {
+        return weights_;
+    }
+
+    const std::uint32_t* GetPrevEdges() const {
+        return prev_edges_;
+    }
+
+private:
+    const Weight* weights_;
+    const std::uint32_t* prev_edges_;
+    std::shared_ptr<const GraphComponents> components_;
+    std::shared_ptr<const void> storage_;
+};
+
+// Непрерывный массив под таблицу всех пар, выровненный по строке кэша. На
+// Linux большой массив выравнивается по 2 МиБ и помечается для прозрачных
+// больших страниц: таблица читается строками подряд, и промахов TLB меньше
+template <typename T>
+class MatrixStorage {
+public:
+    MatrixStorage(size_t size, T value)
+        : size_(size)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const size_t bytes = size * sizeof(T);
+        const size_t alignment = bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : CACHE_LINE_SIZE;
+        const size_t aligned_bytes = std::max<size_t>((bytes + alignment - 1) / alignment * alignment, alignment);
+        data_.reset(static_cast<T*>(std::aligned_alloc(alignment, aligned_bytes)));
+        if (!data_) {
+            throw std::bad_alloc();
+        }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (alignment == HUGE_PAGE_SIZE) {
+            madvise(data_.get(), aligned_bytes, MADV_HUGEPAGE);
+        }
+#endif
+        std::fill_n(data_.get(), size_, value);
+    }
+
+    T* data() {
+        return data_.get();
+    }
+
+    const T* data() const {
+        return data_.get();
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    T& operator[](size_t index) {
+        return data_[index];
+    }
+
+    const T& operator[](size_t index) const {
+        return data_[index];
+    }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+    struct Deleter {
+        void operator()(T* data) const {
+            std::free(data);
+        }
+    };
+
+    std::unique_ptr<T[], Deleter> data_;
+    size_t size_;
+};
+
+// Работа одного поиска
+struct SearchStats {
+    size_t settled_vertices = 0;
+    size_t relaxed_edges = 0;
+    size_t heap_pushes = 0;
+    size_t heap_pops = 0;
+};
+
+// Считает работу поиска и прерывает его после срока. Часы опрашиваются
+// раз в CLOCK_CHECK_PERIOD просмотренных вершин
+class SearchMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t CLOCK_CHECK_PERIOD = 64;
+
+    explicit SearchMonitor(std::optional<Clock::duration> time_limit = std::nullopt)
+        : start_time_(Clock::now())
+    {
+        if (time_limit) {
+            deadline_ = start_time_ + *time_limit;
+        }
+    }
+
+    void OnSettle() {
+        ++stats_.settled_vertices;
+        if (deadline_ && stats_.settled_vertices % CLOCK_CHECK_PERIOD == 0) {
+            CheckDeadline();
+        }
+    }
+
+    void OnRelax() {
+        ++stats_.relaxed_edges;
+    }
+
+    void OnPush() {
+        ++stats_.heap_pushes;
+    }
+
+    void OnPop() {
+        ++stats_.heap_pops;
+    }
+
+    // Срок проверяется сразу, без ожидания очередной вершины
+    bool CheckDeadline() {
+        if (deadline_ && Clock::now() >= *deadline_) {
+            expired_ = true;
+        }
+        return expired_;
+    }
+
+    bool IsExpired() const {
+        return expired_;
+    }
+
+    const SearchStats& GetStats() const {
+        return stats_;
+    }
+
+    Clock::duration GetElapsedTime() const {
+        return Clock::now() - start_time_;
+    }
+
+private:
+    Clock::time_point start_time_;
+    std::optional<Clock::time_point> deadline_;
+    SearchStats stats_;
+    bool expired_ = false;
+};
+
+// Монитор обычных запросов: вызовы пустые и исчезают при компиляции
+struct NullSearchMonitor {
+    void OnSettle() {}
+    void OnRelax() {}
+    void OnPush() {}
+    void OnPop() {}
+
+    constexpr bool CheckDeadline() const {
+        return false;
+    }
+
+    constexpr bool IsExpired() const {
+        return false;
+    }
+};
+
+template <typename Weight>
+class RouterBase {
+public:
+    virtual ~RouterBase() = default;
+
+    virtual std::optional<RouteInfo<Weight>> BuildRoute(VertexId from, VertexId to) const = 0;
+
+    // Маршрут под наблюдением monitor; если срок вышел, маршрута нет и
+    // monitor.IsExpired(). Движки без пошагового поиска отвечают из таблиц
+    // и индексов за микросекунды, поэтому срок проверяется только до запроса
+    virtual std::optional<RouteInfo<Weight>> BuildMonitoredRoute(VertexId from, VertexId to,
+        SearchMonitor& monitor) const {
+        if (monitor.CheckDeadline()) {
+            return std::nullopt;
+        }
+        return BuildRoute(from, to);
+    }
+};
+
+template <typename Weight>
+class Router : public RouterBase<Weight> {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
+    using Cell = RoutesTableCell<Weight>;
 
 public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+
     explicit Router(const Graph& graph);
 
-    struct RouteInfo {
-        Weight weight;
-        std::vector<EdgeId> edges;
-    };
+    // Таблица графа, который получен дописыванием рёбер начиная с first_new_edge
+    // к графу с уже посчитанной таблицей routes_table; новые вершины могут
+    // добавляться только в конец. Любой новый путь
+    // проходит через начала новых рёбер, поэтому шаги Floyd–Warshall делаются
+    // только через них: O(k * V^2) вместо O(V^3) для k таких вершин
+    Router(const Graph& graph, const RoutesTable<Weight>& routes_table, EdgeId first_new_edge);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    RoutesTableCell<Weight> GetRoutesTableCell(VertexId from, VertexId to) const;
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Таблица живёт, пока жив маршрутизатор
+    RoutesTable<Weight> GetRoutesTable() const {
+        return { weights_.data(), prev_edges_.data(), components_, nullptr };
+    }
+
+    const GraphComponents& GetComponents() const {
+        return *components_;
+    }
 
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
-    };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    // Промежуточные вершины обрабатываются блоками: строки вершин блока
+    // копируются в буфер, и каждая строка таблицы проходит весь блок, оставаясь
+    // в кэше. Шаги внутри строки идут в исходном порядке Floyd–Warshall, поэтому
+    // веса и выбор prev_edge при равенстве те же, что и без блоков
+    static constexpr size_t BLOCK_SIZE = 64;
+    // Строк на одну задачу потока
+    static constexpr size_t ROWS_PER_TASK = 16;
+    // Вес отсутствующего маршрута: любая сумма с ним не меньше текущего веса,
+    // поэтому в цикле релаксации не нужны проверки наличия маршрута. Для целых
+    // весов это половина типа: сумма двух весов таблицы не переполняется, а
+    // маршруты не короче этой границы считаются отсутствующими
+    static constexpr Weight UNREACHABLE_WEIGHT = std::numeric_limits<Weight>::has_infinity
+        ? std::numeric_limits<Weight>::infinity() : std::numeric_limits<Weight>::max() / 2;
+
+    static void CheckEdgeCount(const Graph& graph) {
+        if (graph.GetEdgeCount() >= Cell::NO_PREV_EDGE) {
+            throw std::length_error("Too many edges for the routes table");
+        }
+    }
+
+    // Начало строки вершины в таблице её компоненты
+    size_t GetRow(VertexId vertex) const {
+        const size_t component = components_->GetComponent(vertex);
+        return components_->GetCellOffset(component)
+            + components_->GetLocalId(vertex) * components_->GetComponentSize(component);
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            const size_t row = GetRow(vertex);
+            weights_[row + components_->GetLocalId(vertex)] = ZERO_WEIGHT;
+            prev_edges_[row + components_->GetLocalId(vertex)] = Cell::NO_PREV_EDGE;
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{ edge.weight, edge_id };
+                const size_t cell = row + components_->GetLocalId(edge.to);
+                if (weights_[cell] > edge.weight) {
+                    weights_[cell] = edge.weight;
+                    prev_edges_[cell] = static_cast<std::uint32_t>(edge_id);
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-        const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = { candidate_weight,
-                                route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
+    // Шаг Floyd–Warshall для одной строки компоненты: маршруты из local_from
+    // через local_through. На SSE2 цикл идёт по два элемента для double и по
+    // четыре для uint32_t, маска сравнения весов выбирает и вес, и последнее
+    // ребро без ветвлений
+    void RelaxRow(size_t component, size_t local_from, size_t local_through,
+        const Weight* through_weights, const std::uint32_t* through_prev_edges) {
+        const size_t size = components_->GetComponentSize(component);
+        const size_t row = components_->GetCellOffset(component) + local_from * size;
+        if (prev_edges_[row + local_through] == Cell::NO_ROUTE) {
+            return;
+        }
+        const Weight route_from_weight = weights_[row + local_through];
+        Weight* row_weights = weights_.data() + row;
+        std::uint32_t* row_prev_edges = prev_edges_.data() + row;
+        size_t local_to = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        if constexpr (std::is_same_v<Weight, double>) {
+            const __m128d route_from = _mm_set1_pd(route_from_weight);
+            for (; local_to + 2 <= size; local_to += 2) {
+                const __m128d candidate = _mm_add_pd(route_from, _mm_loadu_pd(through_weights + local_to));
+                const __m128d current = _mm_loadu_pd(row_weights + local_to);
+                const __m128i relaxed = _mm_shuffle_epi32(_mm_castpd_si128(_mm_cmplt_pd(candidate, current)),
+                    _MM_SHUFFLE(2, 0, 2, 0));
+                _mm_storeu_pd(row_weights + local_to, _mm_min_pd(candidate, current));
+
+                auto* prev_edges = reinterpret_cast<__m128i*>(row_prev_edges + local_to);
+                const __m128i through = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(through_prev_edges + local_to));
+                _mm_storel_epi64(prev_edges, _mm_or_si128(_mm_and_si128(relaxed, through),
+                    _mm_andnot_si128(relaxed, _mm_loadl_epi64(prev_edges))));
+            }
+        } else if constexpr (std::is_same_v<Weight, std::uint32_t>) {
+            // В SSE2 нет беззнакового сравнения, поэтому оба числа сдвигаются на 2^31
+            const __m128i sign = _mm_set1_epi32(std::numeric_limits<std::int32_t>::min());
+            const __m128i route_from = _mm_set1_epi32(static_cast<std::int32_t>(route_from_weight));
+            for (; local_to + 4 <= size; local_to += 4) {
+                auto* weights = reinterpret_cast<__m128i*>(row_weights + local_to);
+                const __m128i candidate = _mm_add_epi32(route_from,
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(through_weights + local_to)));
+                const __m128i current = _mm_loadu_si128(weights);
+                const __m128i relaxed = _mm_cmplt_epi32(_mm_xor_si128(candidate, sign), _mm_xor_si128(current, sign));
+                _mm_storeu_si128(weights, _mm_or_si128(_mm_and_si128(relaxed, candidate),
+                    _mm_andnot_si128(relaxed, current)));
+
+                auto* prev_edges = reinterpret_cast<__m128i*>(row_prev_edges + local_to);
+                const __m128i through = _mm_loadu_si128(reinterpret_cast<const __m128i*>(through_prev_edges + local_to));
+                _mm_storeu_si128(prev_edges, _mm_or_si128(_mm_and_si128(relaxed, through),
+                    _mm_andnot_si128(relaxed, _mm_loadu_si128(prev_edges))));
+            }
+        }
+#endif
+        for (; local_to < size; ++local_to) {
+            const Weight candidate_weight = route_from_weight + through_weights[local_to];
+            if (candidate_weight < row_weights[local_to]) {
+                row_weights[local_to] = candidate_weight;
+                row_prev_edges[local_to] = through_prev_edges[local_to];
+            }
         }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+    // Шаги Floyd–Warshall через блок вершин компоненты, заданных местами в
+    // ней по возрастанию
+    void RelaxRoutesInternalDataThroughBlock(size_t component, const std::vector<size_t>& block) {
+        const size_t size = components_->GetComponentSize(component);
+        const size_t cell_offset = components_->GetCellOffset(component);
+        const size_t block_size = block.size();
+        std::vector<Weight> block_weights(block_size * size);
+        std::vector<std::uint32_t> block_prev_edges(block_size * size);
+
+        // Строки самого блока меняются на его же шагах, поэтому копия строки
+        // снимается прямо перед её шагом
+        for (size_t i = 0; i < block_size; ++i) {
+            const size_t local_through = block[i];
+            const size_t offset = i * size;
+            std::copy_n(weights_.data() + cell_offset + local_through * size, size,
+                block_weights.begin() + offset);
+            std::copy_n(prev_edges_.data() + cell_offset + local_through * size, size,
+                block_prev_edges.begin() + offset);
+            for (const size_t local_from : block) {
+                RelaxRow(component, local_from, local_through,
+                    block_weights.data() + offset, block_prev_edges.data() + offset);
+            }
+        }
+
+        // Остальные строки зависят только от строк блока и обрабатываются параллельно
+        std::atomic<size_t> next_row{ 0 };
+        const auto relax_rows = [&]() {
+            for (size_t first_row = next_row.fetch_add(ROWS_PER_TASK); first_row < size;
+                first_row = next_row.fetch_add(ROWS_PER_TASK)) {
+                const size_t last_row = std::min(first_row + ROWS_PER_TASK, size);
+                for (size_t local_from = first_row; local_from < last_row; ++local_from) {
+                    if (std::binary_search(block.begin(), block.end(), local_from)) {
+                        continue;
+                    }
+                    for (size_t i = 0; i < block_size; ++i) {
+                        const size_t offset = i * size;
+                        RelaxRow(component, local_from, block[i],
+                            block_weights.data() + offset, block_prev_edges.data() + offset);
                     }
                 }
             }
+        };
+        const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+            (size + ROWS_PER_TASK - 1) / ROWS_PER_TASK);
+        std::vector<std::future<void>> workers;
+        for (size_t i = 1; i < thread_count; ++i) {
+            workers.push_back(std::async(std::launch::async, relax_rows));
+        }
+        relax_rows();
+        for (auto& worker : workers) {
+            worker.get();
         }
     }
 
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
-    RoutesInternalData routes_internal_data_;
+    size_t vertex_count_;
+    std::shared_ptr<const GraphComponents> components_;
+    // Таблицы компонент построчно одна за другой; веса и последние рёбра лежат
+    // в отдельных массивах, ребро хранится в 32 битах
+    MatrixStorage<Weight> weights_;
+    MatrixStorage<std::uint32_t> prev_edges_;
 };
 
 template <typename Weight>
 Router<Weight>::Router(const Graph& graph)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-        std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , vertex_count_(graph.GetVertexCount())
+    , components_(std::make_shared<const GraphComponents>(graph))
+    , weights_(components_->GetCellCount(), UNREACHABLE_WEIGHT)
+    , prev_edges_(components_->GetCellCount(), Cell::NO_ROUTE)
 {
+    CheckEdgeCount(graph);
     InitializeRoutesInternalData(graph);
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    std::vector<size_t> block;
+    block.reserve(BLOCK_SIZE);
+    for (size_t component = 0; component < components_->GetComponentCount(); ++component) {
+        const size_t size = components_->GetComponentSize(component);
+        for (size_t block_begin = 0; block_begin < size; block_begin += BLOCK_SIZE) {
+            block.clear();
+            for (size_t local_id = block_begin; local_id < std::min(block_begin + BLOCK_SIZE, size); ++local_id) {
+                block.push_back(local_id);
+            }
+            RelaxRoutesInternalDataThroughBlock(component, block);
+        }
+    }
+}
+
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, const RoutesTable<Weight>& routes_table, EdgeId first_new_edge)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , components_(std::make_shared<const GraphComponents>(graph))
+    , weights_(components_->GetCellCount(), UNREACHABLE_WEIGHT)
+    , prev_edges_(components_->GetCellCount(), Cell::NO_ROUTE)
+{
+    const size_t table_vertex_count = routes_table.GetVertexCount();
+    if (table_vertex_count > vertex_count_) {
+        throw std::invalid_argument("Routes table doesn't match the graph");
+    }
+    CheckEdgeCount(graph);
+    // Новые рёбра только объединяют компоненты, поэтому старые маршруты
+    // остаются внутри новых компонент
+    for (size_t component = 0; component < components_->GetComponentCount(); ++component) {
+        const size_t size = components_->GetComponentSize(component);
+        const size_t cell_offset = components_->GetCellOffset(component);
+        for (size_t local_from = 0; local_from < size; ++local_from) {
+            const VertexId vertex_from = components_->GetVertex(component, local_from);
+            if (vertex_from >= table_vertex_count) {
+                continue;
+            }
+            for (size_t local_to = 0; local_to < size; ++local_to) {
+                const VertexId vertex_to = components_->GetVertex(component, local_to);
+                if (vertex_to >= table_vertex_count) {
+                    continue;
+                }
+                const Cell cell = routes_table.GetCell(vertex_from, vertex_to);
+                if (cell.prev_edge != Cell::NO_ROUTE) {
+                    weights_[cell_offset + local_from * size + local_to] = cell.weight;
+                    prev_edges_[cell_offset + local_from * size + local_to] = cell.prev_edge;
+                }
+            }
+        }
+    }
+    // Из новых вершин пока есть только пустые маршруты в себя
+    for (VertexId vertex = table_vertex_count; vertex < vertex_count_; ++vertex) {
+        weights_[GetRow(vertex) + components_->GetLocalId(vertex)] = ZERO_WEIGHT;
+        prev_edges_[GetRow(vertex) + components_->GetLocalId(vertex)] = Cell::NO_PREV_EDGE;
+    }
+
+    // Новое ребро u -> v продлевает маршруты из v на строку u. Строка v могла
+    // уже измениться, но в ней только настоящие маршруты нового графа
+    std::vector<VertexId> new_edge_sources;
+    for (EdgeId edge_id = first_new_edge; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        new_edge_sources.push_back(edge.from);
+        const size_t size = components_->GetComponentSize(components_->GetComponent(edge.from));
+        const size_t row = GetRow(edge.from);
+        const size_t through_row = GetRow(edge.to);
+        for (size_t local_to = 0; local_to < size; ++local_to) {
+            const Weight candidate_weight = edge.weight + weights_[through_row + local_to];
+            if (candidate_weight < weights_[row + local_to]) {
+                weights_[row + local_to] = candidate_weight;
+                const std::uint32_t through_prev_edge = prev_edges_[through_row + local_to];
+                prev_edges_[row + local_to] = through_prev_edge == Cell::NO_PREV_EDGE
+                    ? static_cast<std::uint32_t>(edge_id) : through_prev_edge;
+            }
+        }
+    }
+    std::sort(new_edge_sources.begin(), new_edge_sources.end(), [this](VertexId lhs, VertexId rhs) {
+        return std::pair(components_->GetComponent(lhs), lhs) < std::pair(components_->GetComponent(rhs), rhs);
+    });
+    new_edge_sources.erase(std::unique(new_edge_sources.begin(), new_edge_sources.end()), new_edge_sources.end());
+
+    // Блоки берутся внутри одной компоненты
+    std::vector<size_t> block;
+    block.reserve(BLOCK_SIZE);
+    for (size_t i = 0; i < new_edge_sources.size(); ++i) {
+        const size_t component = components_->GetComponent(new_edge_sources[i]);
+        block.push_back(components_->GetLocalId(new_edge_sources[i]));
+        if (block.size() == BLOCK_SIZE || i + 1 == new_edge_sources.size()
+            || components_->GetComponent(new_edge_sources[i + 1]) != component) {
+            RelaxRoutesInternalDataThroughBlock(component, block);
+            block.clear();
+        }
     }
 }
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
     VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    // Между компонентами маршрутов нет, и таблица не нужна
+    if (components_->GetComponent(from) != components_->GetComponent(to)) {
+        return std::nullopt;
+    }
+    const size_t row = GetRow(from);
+    const size_t cell = row + components_->GetLocalId(to);
+    if (prev_edges_[cell] == Cell::NO_ROUTE) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
+    const Weight weight = weights_[cell];
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-        edge_id;
-        edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (std::uint32_t edge_id = prev_edges_[cell];
+        edge_id != Cell::NO_PREV_EDGE;
+        edge_id = prev_edges_[row + components_->GetLocalId(graph_.GetEdge(edge_id).from)])
     {
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
     return RouteInfo{ weight, std::move(edges) };
 }
 
+template <typename Weight>
+RoutesTableCell<Weight> Router<Weight>::GetRoutesTableCell(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const auto cell = components_->GetCell(from, to);
+    if (!cell || prev_edges_[*cell] == Cell::NO_ROUTE) {
+        return { ZERO_WEIGHT, Cell::NO_ROUTE };
+    }
+    return { weights_[*cell], prev_edges_[*cell] };
+}
+
 }  // namespace graph
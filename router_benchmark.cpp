@@ -0,0 +1,165 @@
+#include "router_benchmark.h"
+#include "json_reader.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+namespace router_benchmark {
+    RouterBenchmark::RouterBenchmark(
+            const transport_catalogue::TransportCatalogue &transport_catalogue,
+            transport_router::TransportRouter::RoutingSettings routing_settings
+    ) : transport_catalogue_(transport_catalogue), routing_settings_(routing_settings) {
+        vector<string> stop_names;
+        for (const auto &[stop_name, stop]: transport_catalogue_.GetSortedStops()) {
+            stop_names.push_back(stop_name);
+        }
+        if (stop_names.empty()) {
+            return;
+        }
+
+        mt19937 generator(42);
+        uniform_int_distribution<size_t> stop_distribution(0, stop_names.size() - 1);
+        queries_.reserve(QUERY_COUNT);
+        for (size_t i = 0; i < QUERY_COUNT; ++i) {
+            queries_.push_back({stop_names[stop_distribution(generator)], stop_names[stop_distribution(generator)]});
+        }
+    }
+
+    json::Node RouterBenchmark::Run(const vector<string> &router_types) {
+        transport_router::TransportRouter::RoutingSettings graph_settings = routing_settings_;
+        graph_settings.router_type_ = transport_router::TransportRouter::RouterType::DIJKSTRA;
+        transport_router::TransportRouter graph_router(graph_settings);
+        const auto &graph = graph_router.BuildGraph(transport_catalogue_);
+
+        json::Array engines;
+        vector<optional<double>> reference_weights;
+        for (const string &router_type: router_types) {
+            engines.push_back(RunEngine(router_type, reference_weights));
+        }
+
+        return json::Dict{
+                {"vertex_count"s, static_cast<int>(graph.GetVertexCount())},
+                {"edge_count"s, static_cast<int>(graph.GetEdgeCount())},
+                {"query_count"s, static_cast<int>(queries_.size())},
+                {"engines"s, engines}
+        };
+    }
+
+    json::Node RouterBenchmark::RunEngine(
+            const string &router_type,
+            vector<optional<double>> &reference_weights
+    ) const {
+        using Clock = chrono::steady_clock;
+
+        transport_router::TransportRouter::RoutingSettings routing_settings = routing_settings_;
+        routing_settings.router_type_ = json_reader::JsonReader::RouterTypeDeterminant(json::Node{router_type});
+        transport_router::TransportRouter router(routing_settings);
+
+        const auto build_start = Clock::now();
+        const auto &graph = router.BuildGraph(transport_catalogue_);
+        const double build_ms = chrono::duration<double, milli>(Clock::now() - build_start).count();
+
+        vector<optional<double>> weights;
+        weights.reserve(queries_.size());
+        const auto query_start = Clock::now();
+        for (const Query &query: queries_) {
+            const auto route = router.FindRoute(query.from, query.to);
+            weights.push_back(route ? optional<double>(route->total_time) : nullopt);
+        }
+        const double query_ns = chrono::duration<double, nano>(Clock::now() - query_start).count()
+                                / static_cast<double>(max<size_t>(queries_.size(), 1));
+
+        // Первый движок - эталон, с ним сравниваются веса маршрутов остальных
+        int mismatches = 0;
+        if (reference_weights.empty()) {
+            reference_weights = weights;
+        } else {
+            for (size_t i = 0; i < weights.size(); ++i) {
+                if (weights[i].has_value() != reference_weights[i].has_value()
+                    || (weights[i] && abs(*weights[i] - *reference_weights[i]) > 1e-9 * max(1.0, abs(*weights[i])))) {
+                    ++mismatches;
+                }
+            }
+        }
+
+        json::Dict report{
+                {"name"s, router_type},
+                {"build_ms"s, build_ms},
+                {"query_ns"s, query_ns},
+                {"mismatches"s, mismatches}
+        };
+
+        if (const auto settled_vertex_count = router.GetSettledVertexCount()) {
+            report["settled_per_query"s] = static_cast<double>(*settled_vertex_count)
+                                           / static_cast<double>(max<size_t>(queries_.size(), 1));
+        }
+        if (routing_settings.route_cache_size_ > 0) {
+            report["cache_hits"s] = static_cast<double>(router.GetRouteCacheHitCount());
+            report["cache_misses"s] = static_cast<double>(router.GetRouteCacheMissCount());
+        }
+
+        const size_t vertex_count = graph.GetVertexCount();
+        if (const auto *all_pairs_router = router.GetAllPairsRouter()) {
+            const auto &components = all_pairs_router->GetComponents();
+            report["component_count"s] = static_cast<int>(components.GetComponentCount());
+            report["index_bytes"s] = static_cast<double>(components.GetCellCount()
+                                                         * (sizeof(double) + sizeof(std::uint32_t)));
+        }
+        if (const auto *fixed_point_all_pairs_router = router.GetFixedPointAllPairsRouter()) {
+            const auto &components = fixed_point_all_pairs_router->GetComponents();
+            report["component_count"s] = static_cast<int>(components.GetComponentCount());
+            report["index_bytes"s] = static_cast<double>(components.GetCellCount() * 2 * sizeof(std::uint32_t));
+        }
+        if (const auto *overlay_router = router.GetOverlayRouter()) {
+            const auto &partition = overlay_router->GetShortcuts().GetPartition();
+            report["cell_count"s] = static_cast<int>(partition.GetCellCount());
+            report["boundary_vertex_count"s] = static_cast<int>(partition.GetBoundaryVertexCount());
+            report["index_bytes"s] = static_cast<double>(
+                    partition.GetShortcutCount() * sizeof(double) + vertex_count * sizeof(std::uint32_t)
+            );
+        }
+        if (const auto *ch_router = router.GetContractionHierarchyRouter()) {
+            const auto &hierarchy = ch_router->GetHierarchy();
+            report["shortcut_count"s] = static_cast<int>(hierarchy.edges.size() - graph.GetEdgeCount());
+            report["index_bytes"s] = static_cast<double>(
+                    hierarchy.edges.size() * sizeof(hierarchy.edges.front()) + hierarchy.ranks.size() * sizeof(size_t)
+            );
+        }
+        if (const auto *hub_label_router = router.GetHubLabelRouter()) {
+            const auto &index = hub_label_router->GetIndex();
+            size_t max_labels = 0;
+            for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+                max_labels = max(max_labels, index.forward.offsets[vertex + 1] - index.forward.offsets[vertex]);
+                max_labels = max(max_labels, index.backward.offsets[vertex + 1] - index.backward.offsets[vertex]);
+            }
+            const size_t label_count = index.forward.hubs.size() + index.backward.hubs.size();
+            const double vertices = static_cast<double>(max<size_t>(vertex_count, 1));
+            report["forward_labels_per_vertex"s] = static_cast<double>(index.forward.hubs.size()) / vertices;
+            report["backward_labels_per_vertex"s] = static_cast<double>(index.backward.hubs.size()) / vertices;
+            report["max_labels_per_vertex"s] = static_cast<int>(max_labels);
+            report["index_bytes"s] = static_cast<double>(
+                    label_count * (sizeof(graph::HubLabelRouter<double>::HubRank) + sizeof(double) + sizeof(graph::EdgeId))
+                    + 2 * (vertex_count + 1) * sizeof(size_t)
+            );
+        }
+        if (const auto *raptor_router = router.GetRaptorRouter()) {
+            report["pattern_count"s] = static_cast<int>(raptor_router->GetPatternCount());
+            report["index_bytes"s] = static_cast<double>(raptor_router->GetIndexBytes());
+        }
+        return report;
+    }
+
+    void PrintBenchmark(
+            const transport_catalogue::TransportCatalogue &transport_catalogue,
+            transport_router::TransportRouter::RoutingSettings routing_settings,
+            const vector<string> &router_types,
+            ostream &out
+    ) {
+        RouterBenchmark benchmark(transport_catalogue, routing_settings);
+        json::Print(json::Document{benchmark.Run(router_types)}, out);
+    }
+} // namespace router_benchmark
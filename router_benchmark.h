@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "json.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+namespace router_benchmark {
+    // Сравнивает движки маршрутизации на одном и том же каталоге: время
+    // построения, среднее время запроса Route и размер индекса
+    class RouterBenchmark {
+    public:
+        static constexpr size_t QUERY_COUNT = 100000;
+
+        RouterBenchmark(
+                const transport_catalogue::TransportCatalogue &transport_catalogue,
+                transport_router::TransportRouter::RoutingSettings routing_settings
+        );
+
+        json::Node Run(const std::vector<std::string> &router_types);
+    private:
+        struct Query {
+            std::string from;
+            std::string to;
+        };
+
+        const transport_catalogue::TransportCatalogue &transport_catalogue_;
+        transport_router::TransportRouter::RoutingSettings routing_settings_;
+        std::vector<Query> queries_;
+
+        json::Node RunEngine(
+                const std::string &router_type,
+                std::vector<std::optional<double>> &reference_weights
+        ) const;
+    };
+
+    void PrintBenchmark(
+            const transport_catalogue::TransportCatalogue &transport_catalogue,
+            transport_router::TransportRouter::RoutingSettings routing_settings,
+            const std::vector<std::string> &router_types,
+            std::ostream &out
+    );
+} // namespace router_benchmark
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "router.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Отвечает на запросы по уже посчитанной таблице, не запуская Floyd–Warshall
+template <typename Weight>
+class TableRouter : public RouterBase<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using Cell = RoutesTableCell<Weight>;
+
+public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    TableRouter(const Graph& graph, RoutesTable<Weight> routes_table);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    const RoutesTable<Weight>& GetRoutesTable() const {
+        return routes_table_;
+    }
+
+private:
+    const Graph& graph_;
+    RoutesTable<Weight> routes_table_;
+};
+
+template <typename Weight>
+TableRouter<Weight>::TableRouter(const Graph& graph, RoutesTable<Weight> routes_table)
+    : graph_(graph)
+    , routes_table_(std::move(routes_table))
+{
+    if (routes_table_.GetVertexCount() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Routes table doesn't match the graph");
+    }
+}
+
+template <typename Weight>
+std::optional<typename TableRouter<Weight>::RouteInfo> TableRouter<Weight>::BuildRoute(VertexId from,
+    VertexId to) const {
+    if (from >= routes_table_.GetVertexCount() || to >= routes_table_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const Cell cell = routes_table_.GetCell(from, to);
+    if (cell.prev_edge == Cell::NO_ROUTE) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (std::uint32_t edge_id = cell.prev_edge;
+        edge_id != Cell::NO_PREV_EDGE;
+        edge_id = routes_table_.GetCell(from, graph_.GetEdge(edge_id).from).prev_edge)
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{ cell.weight, std::move(edges) };
+}
+
+}  // namespace graph
@@ -1,11 +1,72 @@
 #include "serialization.h"
 
+#include <algorithm>
 #include <string>
 #include <fstream>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
 namespace serialization {
+    std::shared_ptr<const MappedFile> MappedFile::Open(const std::string &path) {
+        std::shared_ptr<MappedFile> file(new MappedFile);
+#if defined(__unix__) || defined(__APPLE__)
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat file_stat{};
+        if (fstat(fd, &file_stat) != 0) {
+            close(fd);
+            return nullptr;
+        }
+        file->size_ = static_cast<size_t>(file_stat.st_size);
+        if (file->size_ > 0) {
+            void *data = mmap(nullptr, file->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                close(fd);
+                return nullptr;
+            }
+            file->data_ = static_cast<const char *>(data);
+        }
+        close(fd);
+#else
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            return nullptr;
+        }
+        file->buffer_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        file->data_ = file->buffer_.data();
+        file->size_ = file->buffer_.size();
+#endif
+        return file;
+    }
+
+    MappedFile::~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (data_ != nullptr) {
+            munmap(const_cast<char *>(data_), size_);
+        }
+#endif
+    }
+
+    const char *MappedFile::GetData() const {
+        return data_;
+    }
+
+    size_t MappedFile::GetSize() const {
+        return size_;
+    }
+
+    //------------------------------------------------------------------------------------------------------------------
     void Serialize(
             const transport_catalogue::TransportCatalogue &catalogue,
             const renderer::MapRenderer &renderer,
@@ -20,7 +81,36 @@ namespace serialization {
         SerializeRenderSettings(renderer, proto_catalogue);
         SerializeRouter(router, proto_catalogue);
 
-        proto_catalogue.SerializeToOstream(&out);
+        const std::string catalogue_data = proto_catalogue.SerializeAsString();
+        const graph::Router<double> *all_pairs_router = router.GetAllPairsRouter();
+        const graph::Router<std::uint32_t> *fixed_point_all_pairs_router = router.GetFixedPointAllPairsRouter();
+        const graph::OverlayRouter<double> *overlay_router = router.GetOverlayRouter();
+        const bool has_routes_table = all_pairs_router != nullptr || fixed_point_all_pairs_router != nullptr
+                                      || overlay_router != nullptr;
+
+        BaseHeader header{};
+        std::memcpy(header.signature, BaseHeader::SIGNATURE, sizeof(header.signature));
+        header.catalogue_size = catalogue_data.size();
+        if (has_routes_table) {
+            const std::uint64_t catalogue_end = sizeof(header) + catalogue_data.size();
+            header.routes_table_offset = (catalogue_end + BaseHeader::ROUTES_TABLE_ALIGNMENT - 1)
+                                         / BaseHeader::ROUTES_TABLE_ALIGNMENT * BaseHeader::ROUTES_TABLE_ALIGNMENT;
+            header.routes_table_vertex_count = router.GetGraph().GetVertexCount();
+        }
+
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(catalogue_data.data(), static_cast<std::streamsize>(catalogue_data.size()));
+        if (has_routes_table) {
+            const std::string padding(header.routes_table_offset - sizeof(header) - catalogue_data.size(), '\0');
+            out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+            if (all_pairs_router != nullptr) {
+                SerializeRoutesTable(all_pairs_router->GetRoutesTable(), out);
+            } else if (overlay_router != nullptr) {
+                SerializeOverlayShortcuts(overlay_router->GetShortcuts(), out);
+            } else {
+                SerializeRoutesTable(fixed_point_all_pairs_router->GetRoutesTable(), out);
+            }
+        }
     }
 
     void SerializeStops(
@@ -154,6 +244,18 @@ namespace serialization {
 
             *proto_router.add_stop_ids() = proto_stop_id;
         }
+        for (const int distance: router.GetEdgeDistances()) {
+            proto_router.add_edge_distance(distance);
+        }
+        if (const auto *ch_router = router.GetContractionHierarchyRouter()) {
+            *proto_router.mutable_contraction_hierarchy() = SerializeContractionHierarchy(
+                    ch_router->GetHierarchy(),
+                    router.GetGraph().GetEdgeCount()
+            );
+        }
+        if (const auto *hub_label_router = router.GetHubLabelRouter()) {
+            *proto_router.mutable_hub_labels() = SerializeHubLabels(hub_label_router->GetIndex());
+        }
         *proto_catalogue.mutable_router() = std::move(proto_router);
     }
 
@@ -163,6 +265,19 @@ namespace serialization {
         transport_router::TransportRouter::RoutingSettings routing_settings = router.GetRoutingSettings();
         proto_router_settings.set_bus_wait_time(routing_settings.bus_wait_time_);
         proto_router_settings.set_bus_velocity(routing_settings.bus_velocity_);
+        proto_router_settings.set_router_type(
+                static_cast<proto_transport::RouterType>(routing_settings.router_type_)
+        );
+        proto_router_settings.set_route_cache_size(routing_settings.route_cache_size_);
+        proto_router_settings.set_graph_model(
+                static_cast<proto_transport::GraphModel>(routing_settings.graph_model_)
+        );
+        proto_router_settings.set_wait_on_boarding(routing_settings.wait_on_boarding_);
+        proto_router_settings.set_fixed_point_weights(routing_settings.fixed_point_weights_);
+        proto_router_settings.set_vertex_order(
+                static_cast<proto_transport::VertexOrder>(routing_settings.vertex_order_)
+        );
+        proto_router_settings.set_overlay_cell_size(routing_settings.overlay_cell_size_);
 
         return proto_router_settings;
     }
@@ -172,7 +287,7 @@ namespace serialization {
         for (int i = 0; i < graph.GetEdgeCount(); ++i) {
             graph::Edge edge = graph.GetEdge(i);
             proto_graph::Edge proto_edge;
-            proto_edge.set_name(edge.name);
+            proto_edge.set_name_id(edge.name_id);
             proto_edge.set_quality(edge.quality);
             proto_edge.set_from(edge.from);
             proto_edge.set_to(edge.to);
@@ -191,16 +306,106 @@ namespace serialization {
         return protobuf_graph;
     }
 
+    proto_transport::ContractionHierarchy SerializeContractionHierarchy(
+            const graph::ContractionHierarchyRouter<double>::Hierarchy &hierarchy,
+            size_t graph_edge_count
+    ) {
+        proto_transport::ContractionHierarchy proto_hierarchy;
+        for (const size_t rank: hierarchy.ranks) {
+            proto_hierarchy.add_rank(rank);
+        }
+        // Первые рёбра иерархии повторяют граф и восстанавливаются из него
+        for (size_t i = graph_edge_count; i < hierarchy.edges.size(); ++i) {
+            const auto &edge = hierarchy.edges[i];
+            proto_transport::Shortcut proto_shortcut;
+            proto_shortcut.set_from(edge.from);
+            proto_shortcut.set_to(edge.to);
+            proto_shortcut.set_weight(edge.weight);
+            proto_shortcut.set_first_half(edge.first_half);
+            proto_shortcut.set_second_half(edge.second_half);
+
+            *proto_hierarchy.add_shortcut() = proto_shortcut;
+        }
+        return proto_hierarchy;
+    }
+
+    proto_transport::HubLabels SerializeHubLabels(const graph::HubLabelRouter<double>::Index &hub_labels) {
+        proto_transport::HubLabels proto_hub_labels;
+        *proto_hub_labels.mutable_forward() = SerializeLabels(hub_labels.forward);
+        *proto_hub_labels.mutable_backward() = SerializeLabels(hub_labels.backward);
+
+        return proto_hub_labels;
+    }
+
+    proto_transport::Labels SerializeLabels(const graph::HubLabelRouter<double>::Labels &labels) {
+        proto_transport::Labels proto_labels;
+        proto_labels.mutable_offset()->Add(labels.offsets.begin(), labels.offsets.end());
+        proto_labels.mutable_hub()->Add(labels.hubs.begin(), labels.hubs.end());
+        proto_labels.mutable_distance()->Add(labels.distances.begin(), labels.distances.end());
+        proto_labels.mutable_edge()->Add(labels.edges.begin(), labels.edges.end());
+
+        return proto_labels;
+    }
+
+    template<typename Weight>
+    void SerializeRoutesTable(
+            const graph::RoutesTable<Weight> &routes_table,
+            std::ostream &out
+    ) {
+        const size_t cell_count = routes_table.GetComponents().GetCellCount();
+        out.write(
+                reinterpret_cast<const char *>(routes_table.GetWeights()),
+                static_cast<std::streamsize>(cell_count * sizeof(Weight))
+        );
+        out.write(
+                reinterpret_cast<const char *>(routes_table.GetPrevEdges()),
+                static_cast<std::streamsize>(cell_count * sizeof(std::uint32_t))
+        );
+    }
+
+    // Сначала ячейки вершин, дополненные до 8 байт, затем матрицы переходов
+    void SerializeOverlayShortcuts(
+            const graph::OverlayShortcuts<double> &shortcuts,
+            std::ostream &out
+    ) {
+        const std::vector<std::uint32_t> &vertex_cells = shortcuts.GetPartition().GetVertexCells();
+        out.write(
+                reinterpret_cast<const char *>(vertex_cells.data()),
+                static_cast<std::streamsize>(vertex_cells.size() * sizeof(std::uint32_t))
+        );
+        const std::string padding(GetOverlayCellsSize(vertex_cells.size()) - vertex_cells.size() * sizeof(std::uint32_t), '\0');
+        out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        out.write(
+                reinterpret_cast<const char *>(shortcuts.GetWeights()),
+                static_cast<std::streamsize>(shortcuts.GetPartition().GetShortcutCount() * sizeof(double))
+        );
+    }
+
+    std::uint64_t GetOverlayCellsSize(std::uint64_t vertex_count) {
+        return (vertex_count * sizeof(std::uint32_t) + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+    }
+
     //------------------------------------------------------------------------------------------------------------------
     std::tuple<
             transport_catalogue::TransportCatalogue,
             renderer::MapRenderer,
-            transport_router::TransportRouter,
-            graph::DirectedWeightedGraph<double>,
-            std::map<std::string, graph::VertexId>
-    > Deserialize(std::istream &input) {
+            transport_router::TransportRouter
+    > Deserialize(const std::shared_ptr<const MappedFile> &base) {
+        BaseHeader header{};
+        const char *catalogue_data = base->GetData();
+        size_t catalogue_size = base->GetSize();
+        if (base->GetSize() >= sizeof(header)
+            && std::memcmp(base->GetData(), BaseHeader::SIGNATURE, sizeof(header.signature)) == 0) {
+            std::memcpy(&header, base->GetData(), sizeof(header));
+            catalogue_data = base->GetData() + sizeof(header);
+            catalogue_size = header.catalogue_size;
+        }
+
         proto_transport::Catalogue proto_catalogue;
-        proto_catalogue.ParseFromIstream(&input);
+        if (catalogue_data + catalogue_size > base->GetData() + base->GetSize()
+            || !proto_catalogue.ParseFromArray(catalogue_data, static_cast<int>(catalogue_size))) {
+            throw std::runtime_error("Error deserialized catalogue");
+        }
 
         transport_catalogue::TransportCatalogue catalogue;
 
@@ -214,9 +419,107 @@ namespace serialization {
         };
 
         transport_router::TransportRouter router(DeserializeRoutingSettings(proto_catalogue));
-        router.FillRouter(
-                DeserializeGraph(proto_catalogue),
-                DeserializeStopIds(proto_catalogue)
+        if (header.routes_table_offset != 0
+            && router.GetRoutingSettings().router_type_ == transport_router::TransportRouter::RouterType::CELL_OVERLAY) {
+            graph::DirectedWeightedGraph<double> graph = DeserializeGraph(proto_catalogue);
+            const std::uint64_t vertex_count = graph.GetVertexCount();
+            const std::uint64_t cells_size = GetOverlayCellsSize(vertex_count);
+            if (header.routes_table_vertex_count != vertex_count
+                || header.routes_table_offset + cells_size > base->GetSize()) {
+                throw std::runtime_error("Error deserialized overlay");
+            }
+            const auto *cells = reinterpret_cast<const std::uint32_t *>(base->GetData() + header.routes_table_offset);
+            std::vector<std::uint32_t> vertex_cells(cells, cells + vertex_count);
+            if (std::any_of(vertex_cells.begin(), vertex_cells.end(), [vertex_count](std::uint32_t cell) {
+                return cell >= vertex_count;
+            })) {
+                throw std::runtime_error("Error deserialized overlay");
+            }
+            // Переходы не копируются: страницы ячеек подгружаются из файла по мере запросов
+            auto partition = std::make_shared<const graph::GraphPartition>(graph, std::move(vertex_cells));
+            const std::uint64_t shortcuts_offset = header.routes_table_offset + cells_size;
+            if (shortcuts_offset + partition->GetShortcutCount() * sizeof(double) > base->GetSize()) {
+                throw std::runtime_error("Error deserialized overlay");
+            }
+            router.FillRouter(
+                    catalogue,
+                    std::move(graph),
+                    DeserializeStopIds(proto_catalogue),
+                    graph::OverlayShortcuts<double>(
+                            reinterpret_cast<const double *>(base->GetData() + shortcuts_offset),
+                            std::move(partition),
+                            base
+                    )
+            );
+        } else if (header.routes_table_offset != 0) {
+            graph::DirectedWeightedGraph<double> graph = DeserializeGraph(proto_catalogue);
+            // Разбиение на компоненты однозначно задаётся графом и в файле не хранится
+            auto components = std::make_shared<const graph::GraphComponents>(graph);
+            // Веса в таблице целые, если база собрана с fixed_point_weights
+            const bool fixed_point_weights = router.GetRoutingSettings().fixed_point_weights_;
+            const std::uint64_t weight_size = fixed_point_weights ? sizeof(std::uint32_t) : sizeof(double);
+            const std::uint64_t cell_count = components->GetCellCount();
+            const std::uint64_t table_size = cell_count * (weight_size + sizeof(std::uint32_t));
+            if (header.routes_table_vertex_count != graph.GetVertexCount()
+                || header.routes_table_offset + table_size > base->GetSize()) {
+                throw std::runtime_error("Error deserialized routes table");
+            }
+            const char *weights = base->GetData() + header.routes_table_offset;
+            const auto *prev_edges = reinterpret_cast<const std::uint32_t *>(weights + cell_count * weight_size);
+            if (fixed_point_weights) {
+                router.FillRouter(
+                        catalogue,
+                        std::move(graph),
+                        DeserializeStopIds(proto_catalogue),
+                        graph::RoutesTable<std::uint32_t>(
+                                reinterpret_cast<const std::uint32_t *>(weights),
+                                prev_edges,
+                                std::move(components),
+                                base
+                        )
+                );
+            } else {
+                router.FillRouter(
+                        catalogue,
+                        std::move(graph),
+                        DeserializeStopIds(proto_catalogue),
+                        graph::RoutesTable<double>(
+                                reinterpret_cast<const double *>(weights),
+                                prev_edges,
+                                std::move(components),
+                                base
+                        )
+                );
+            }
+        } else if (proto_catalogue.router().has_contraction_hierarchy()) {
+            graph::DirectedWeightedGraph<double> graph = DeserializeGraph(proto_catalogue);
+            auto hierarchy = DeserializeContractionHierarchy(proto_catalogue, graph);
+            router.FillRouter(
+                    catalogue,
+                    std::move(graph),
+                    DeserializeStopIds(proto_catalogue),
+                    std::move(hierarchy)
+            );
+        } else if (proto_catalogue.router().has_hub_labels()) {
+            router.FillRouter(
+                    catalogue,
+                    DeserializeGraph(proto_catalogue),
+                    DeserializeStopIds(proto_catalogue),
+                    DeserializeHubLabels(proto_catalogue)
+            );
+        } else {
+            router.FillRouter(
+                    catalogue,
+                    DeserializeGraph(proto_catalogue),
+                    DeserializeStopIds(proto_catalogue)
+            );
+        }
+
+        router.SetEdgeDistances(
+                {
+                        proto_catalogue.router().edge_distance().begin(),
+                        proto_catalogue.router().edge_distance().end()
+                }
         );
 
         return {
@@ -324,7 +627,20 @@ namespace serialization {
     ) {
         return {
                 proto_catalogue.router().routing_settings().bus_wait_time(),
-                proto_catalogue.router().routing_settings().bus_velocity()
+                proto_catalogue.router().routing_settings().bus_velocity(),
+                static_cast<transport_router::TransportRouter::RouterType>(
+                        proto_catalogue.router().routing_settings().router_type()
+                ),
+                proto_catalogue.router().routing_settings().route_cache_size(),
+                static_cast<transport_router::TransportRouter::GraphModel>(
+                        proto_catalogue.router().routing_settings().graph_model()
+                ),
+                proto_catalogue.router().routing_settings().wait_on_boarding(),
+                proto_catalogue.router().routing_settings().fixed_point_weights(),
+                static_cast<transport_router::TransportRouter::VertexOrder>(
+                        proto_catalogue.router().routing_settings().vertex_order()
+                ),
+                proto_catalogue.router().routing_settings().overlay_cell_size()
         };
     }
 
@@ -335,7 +651,7 @@ namespace serialization {
         for (int i = 0; i < protobuf_graph.edge_size(); ++i) {
             proto_graph::Edge proto_edge = protobuf_graph.edge(i);
             edges[i] = {
-                    proto_edge.name(),
+                    proto_edge.name_id(),
                     static_cast<size_t>(proto_edge.quality()),
                     static_cast<size_t>(proto_edge.from()),
                     static_cast<size_t>(proto_edge.to()),
@@ -359,4 +675,60 @@ namespace serialization {
         }
         return stop_ids;
     }
+
+    graph::ContractionHierarchyRouter<double>::Hierarchy DeserializeContractionHierarchy(
+            const proto_transport::Catalogue &proto_catalogue,
+            const graph::DirectedWeightedGraph<double> &graph
+    ) {
+        using ContractionHierarchyRouter = graph::ContractionHierarchyRouter<double>;
+        const proto_transport::ContractionHierarchy &proto_hierarchy = proto_catalogue.router().contraction_hierarchy();
+
+        ContractionHierarchyRouter::Hierarchy hierarchy;
+        hierarchy.ranks.assign(proto_hierarchy.rank().begin(), proto_hierarchy.rank().end());
+        hierarchy.edges.reserve(graph.GetEdgeCount() + proto_hierarchy.shortcut_size());
+        for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto &edge = graph.GetEdge(edge_id);
+            hierarchy.edges.push_back(
+                    {
+                            edge.from,
+                            edge.to,
+                            edge.weight,
+                            edge_id,
+                            ContractionHierarchyRouter::NO_EDGE,
+                            ContractionHierarchyRouter::NO_EDGE
+                    }
+            );
+        }
+        for (const proto_transport::Shortcut &proto_shortcut: proto_hierarchy.shortcut()) {
+            hierarchy.edges.push_back(
+                    {
+                            static_cast<size_t>(proto_shortcut.from()),
+                            static_cast<size_t>(proto_shortcut.to()),
+                            proto_shortcut.weight(),
+                            ContractionHierarchyRouter::NO_EDGE,
+                            static_cast<size_t>(proto_shortcut.first_half()),
+                            static_cast<size_t>(proto_shortcut.second_half())
+                    }
+            );
+        }
+        return hierarchy;
+    }
+
+    graph::HubLabelRouter<double>::Index DeserializeHubLabels(const proto_transport::Catalogue &proto_catalogue) {
+        const proto_transport::HubLabels &proto_hub_labels = proto_catalogue.router().hub_labels();
+        return {
+                DeserializeLabels(proto_hub_labels.forward()),
+                DeserializeLabels(proto_hub_labels.backward())
+        };
+    }
+
+    graph::HubLabelRouter<double>::Labels DeserializeLabels(const proto_transport::Labels &proto_labels) {
+        graph::HubLabelRouter<double>::Labels labels;
+        labels.offsets.assign(proto_labels.offset().begin(), proto_labels.offset().end());
+        labels.hubs.assign(proto_labels.hub().begin(), proto_labels.hub().end());
+        labels.distances.assign(proto_labels.distance().begin(), proto_labels.distance().end());
+        labels.edges.assign(proto_labels.edge().begin(), proto_labels.edge().end());
+
+        return labels;
+    }
 } // serialization
@@ -7,7 +7,48 @@
 #include "transport_catalogue.h"
 #include "request_handler.h"
 
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
 namespace serialization {
+    // Файл базы: заголовок, сообщение proto_transport::Catalogue и, если
+    // маршрутизатор строит таблицу всех пар, плоская таблица маршрутов: сначала
+    // веса double (uint32 с fixed_point_weights), затем последние рёбра uint32,
+    // в каждом массиве таблицы слабо связных компонент графа одна за другой.
+    // Для cell_overlay на месте таблицы лежат ячейки вершин и матрицы переходов
+    // ячеек. Блок выровнен по странице, чтобы его можно было отобразить в
+    // память и читать без копирования
+    struct BaseHeader {
+        static constexpr char SIGNATURE[8] = {'T', 'C', 'B', 'A', 'S', 'E', '\0', '\4'};
+        static constexpr std::uint64_t ROUTES_TABLE_ALIGNMENT = 4096;
+
+        char signature[8];
+        std::uint64_t catalogue_size;
+        std::uint64_t routes_table_offset;
+        std::uint64_t routes_table_vertex_count;
+    };
+
+    // Файл, отображённый в память только для чтения
+    class MappedFile {
+    public:
+        static std::shared_ptr<const MappedFile> Open(const std::string &path);
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        ~MappedFile();
+
+        const char *GetData() const;
+        size_t GetSize() const;
+    private:
+        MappedFile() = default;
+
+        const char *data_ = nullptr;
+        size_t size_ = 0;
+        std::vector<char> buffer_{};
+    };
+
     void Serialize(
             const transport_catalogue::TransportCatalogue &catalogue,
             const renderer::MapRenderer &renderer,
@@ -51,14 +92,35 @@ namespace serialization {
 
     proto_graph::Graph SerializeGraph(const graph::DirectedWeightedGraph<double> &graph);
 
+    proto_transport::ContractionHierarchy SerializeContractionHierarchy(
+            const graph::ContractionHierarchyRouter<double>::Hierarchy &hierarchy,
+            size_t graph_edge_count
+    );
+
+    proto_transport::HubLabels SerializeHubLabels(const graph::HubLabelRouter<double>::Index &hub_labels);
+
+    proto_transport::Labels SerializeLabels(const graph::HubLabelRouter<double>::Labels &labels);
+
+    template<typename Weight>
+    void SerializeRoutesTable(
+            const graph::RoutesTable<Weight> &routes_table,
+            std::ostream &out
+    );
+
+    void SerializeOverlayShortcuts(
+            const graph::OverlayShortcuts<double> &shortcuts,
+            std::ostream &out
+    );
+
+    // Место под ячейки вершин в блоке разбиения, выровненное под веса переходов
+    std::uint64_t GetOverlayCellsSize(std::uint64_t vertex_count);
+
     //------------------------------------------------------------------------------------------------------------------
     std::tuple<
             transport_catalogue::TransportCatalogue,
             renderer::MapRenderer,
-            transport_router::TransportRouter,
-            graph::DirectedWeightedGraph<double>,
-            std::map<std::string, graph::VertexId>
-    > Deserialize(std::istream &input);
+            transport_router::TransportRouter
+    > Deserialize(const std::shared_ptr<const MappedFile> &base);
 
     void DeserializeStops(
             transport_catalogue::TransportCatalogue &catalogue,
@@ -85,6 +147,15 @@ namespace serialization {
 
     std::map<std::string, graph::VertexId> DeserializeStopIds(const proto_transport::Catalogue &proto_catalogue);
 
+    graph::ContractionHierarchyRouter<double>::Hierarchy DeserializeContractionHierarchy(
+            const proto_transport::Catalogue &proto_catalogue,
+            const graph::DirectedWeightedGraph<double> &graph
+    );
+
+    graph::HubLabelRouter<double>::Index DeserializeHubLabels(const proto_transport::Catalogue &proto_catalogue);
+
+    graph::HubLabelRouter<double>::Labels DeserializeLabels(const proto_transport::Labels &proto_labels);
+
     svg::Point DeserializePoint(const proto_map::Point &proto_point);
 
     svg::Color DeserializeColor(const proto_map::Color &proto_color);
@@ -1,6 +1,13 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <limits>
+#include <stdexcept>
 #include <string_view>
+#include <thread>
 #include <utility>
 
 using namespace std;
@@ -8,82 +15,690 @@ using namespace std;
 namespace transport_router {
 
     const DirectedWeightedGraph<double> &TransportRouter::BuildGraph(const TransportCatalogue &transport_catalogue) {
-        auto stops = transport_catalogue.GetSortedStops();
-        auto buses = transport_catalogue.GetSortedBuses();
+        IndexCatalogue(transport_catalogue);
+        OrderStops();
 
-        DirectedWeightedGraph<double> temp_graph(stops.size() * 2);
+        // RAPTOR ездит по маршрутам автобусов напрямую, в графе ему нужны
+        // только вершины остановок
+        const bool has_bus_edges = routing_settings_.router_type_ != RouterType::RAPTOR;
+        std::vector<VertexId> first_bus_vertices(buses_.size());
+        size_t vertex_count = stops_.size() * GetVerticesPerStop();
+        if (has_bus_edges) {
+            for (size_t bus_id = 0; bus_id < buses_.size(); ++bus_id) {
+                first_bus_vertices[bus_id] = vertex_count;
+                vertex_count += GetBusVertexCount(buses_[bus_id]);
+            }
+        }
 
-        VertexId vertex_id = 0;
+        DirectedWeightedGraph<double> temp_graph(vertex_count);
+        edge_distances_.clear();
 
-        for (const auto &[stop_name, stop]: stops) {
-            stop_ids_[stop_name] = vertex_id;
+        for (std::uint32_t stop_id = 0; stop_id < stops_.size(); ++stop_id) {
+            stop_ids_[stops_[stop_id]->stop_name_] = GetArrivalVertex(stop_id);
 
-            temp_graph.AddEdge(
-                    {
-                            stop_name,
-                            0,
-                            vertex_id,
-                            ++vertex_id,
-                            static_cast<double>(routing_settings_.bus_wait_time_)
-                    }
+            if (!routing_settings_.wait_on_boarding_) {
+                temp_graph.AddEdge(
+                        {
+                                stop_id,
+                                0,
+                                GetArrivalVertex(stop_id),
+                                GetDepartureVertex(stop_id),
+                                static_cast<double>(routing_settings_.bus_wait_time_)
+                        }
+                );
+                edge_distances_.push_back(0);
+            }
+        }
+        IndexStopIds();
+
+        if (has_bus_edges) {
+            // Рёбра автобусов строятся параллельно, каждый автобус в свой буфер, и
+            // добавляются в граф в порядке id автобусов - как при обходе в один поток
+            std::vector<BusEdges> bus_edges(buses_.size());
+            std::atomic<size_t> next_bus_id{0};
+            const auto build_edges = [this, &transport_catalogue, &first_bus_vertices, &bus_edges, &next_bus_id]() {
+                for (size_t bus_id = next_bus_id++; bus_id < bus_edges.size(); bus_id = next_bus_id++) {
+                    bus_edges[bus_id] = BuildBusEdges(
+                            transport_catalogue,
+                            static_cast<std::uint32_t>(bus_id),
+                            first_bus_vertices[bus_id]
+                    );
+                }
+            };
+            const size_t thread_count = std::min<size_t>(
+                    std::max(1u, std::thread::hardware_concurrency()),
+                    bus_edges.size()
             );
+            std::vector<std::future<void>> workers;
+            for (size_t i = 1; i < thread_count; ++i) {
+                workers.push_back(std::async(std::launch::async, build_edges));
+            }
+            build_edges();
+            for (auto &worker: workers) {
+                worker.get();
+            }
 
-            ++vertex_id;
+            for (const auto &[edges, distances]: bus_edges) {
+                for (const auto &edge: edges) {
+                    temp_graph.AddEdge(edge);
+                }
+                edge_distances_.insert(edge_distances_.end(), distances.begin(), distances.end());
+            }
         }
+        temp_graph.Freeze();
+        graph_ = std::make_unique<DirectedWeightedGraph<double>>(std::move(temp_graph));
+        search_router_ = std::make_unique<graph::DijkstraRouter<double>>(*graph_);
+        CreateRouter(transport_catalogue);
 
-        for (const auto &[bus_name, bus]: buses) {
-            int stops_count = static_cast<int>(bus->bus_route_.size());
-            for (int i = 0; i < stops_count; ++i) {
-                for (int j = i + 1; j < stops_count; ++j) {
-                    const domain::Stop *final_stop = bus->bus_route_[i];
-                    const domain::Stop *start_stop = bus->bus_route_[j];
+        return *graph_;
+    }
 
-                    int route_distance = 0;
-                    int back_route_distance = 0;
-                    for (int k = i + 1; k <= j; ++k) {
-                        route_distance += transport_catalogue.GetDistance(bus->bus_route_[k - 1], bus->bus_route_[k]);
-                        back_route_distance += transport_catalogue.GetDistance(bus->bus_route_[k],
-                                                                               bus->bus_route_[k - 1]);
-                    }
-                    temp_graph.AddEdge(
+    void TransportRouter::AddBuses(const TransportCatalogue &transport_catalogue) {
+        const std::vector<const Bus *> old_buses = buses_;
+        IndexCatalogue(transport_catalogue);
+        if (stops_.size() != stop_vertex_ids_.size()) {
+            throw std::invalid_argument("Stops can't be added without rebuilding the graph");
+        }
+        RestoreStopOrder();
+        for (size_t stop_id = 0; stop_id < stops_.size(); ++stop_id) {
+            if (stop_vertex_ids_.at(stops_[stop_id]->stop_name_) != GetArrivalVertex(stop_id)) {
+                throw std::invalid_argument("Stops can't be changed without rebuilding the graph");
+            }
+        }
+
+        // Id автобусов - их места в отсортированном списке, поэтому у старых
+        // рёбер они сдвигаются, если новый автобус встал перед ними
+        std::unordered_map<const Bus *, std::uint32_t> bus_ids;
+        for (std::uint32_t bus_id = 0; bus_id < buses_.size(); ++bus_id) {
+            bus_ids[buses_[bus_id]] = bus_id;
+        }
+        std::vector<std::uint32_t> old_to_new_bus_ids(old_buses.size());
+        for (size_t old_bus_id = 0; old_bus_id < old_buses.size(); ++old_bus_id) {
+            const auto it = bus_ids.find(old_buses[old_bus_id]);
+            if (it == bus_ids.end()) {
+                throw std::invalid_argument("Buses can't be removed without rebuilding the graph");
+            }
+            old_to_new_bus_ids[old_bus_id] = it->second;
+            bus_ids.erase(it);
+        }
+        std::vector<std::uint32_t> added_bus_ids;
+        for (const auto &[bus, bus_id]: bus_ids) {
+            added_bus_ids.push_back(bus_id);
+        }
+        std::sort(added_bus_ids.begin(), added_bus_ids.end());
+
+        const bool has_bus_edges = routing_settings_.router_type_ != RouterType::RAPTOR;
+        // Вершины новых автобусов добавляются после всех прежних вершин
+        std::vector<VertexId> first_bus_vertices;
+        size_t vertex_count = graph_->GetVertexCount();
+        if (has_bus_edges) {
+            for (const std::uint32_t bus_id: added_bus_ids) {
+                first_bus_vertices.push_back(vertex_count);
+                vertex_count += GetBusVertexCount(buses_[bus_id]);
+            }
+        }
+
+        DirectedWeightedGraph<double> temp_graph(vertex_count);
+        for (EdgeId edge_id = 0; edge_id < graph_->GetEdgeCount(); ++edge_id) {
+            Edge<double> edge = graph_->GetEdge(edge_id);
+            if (!IsWaitEdge(edge)) {
+                edge.name_id = old_to_new_bus_ids[edge.name_id];
+            }
+            temp_graph.AddEdge(edge);
+        }
+        const EdgeId first_new_edge = temp_graph.GetEdgeCount();
+        // В базе старого формата расстояний нет, и у новых рёбер их тоже не будет
+        const bool has_edge_distances = edge_distances_.size() == first_new_edge;
+        if (has_bus_edges) {
+            for (size_t i = 0; i < added_bus_ids.size(); ++i) {
+                const auto [edges, distances] = BuildBusEdges(
+                        transport_catalogue,
+                        added_bus_ids[i],
+                        first_bus_vertices[i]
+                );
+                for (const auto &edge: edges) {
+                    temp_graph.AddEdge(edge);
+                }
+                if (has_edge_distances) {
+                    edge_distances_.insert(edge_distances_.end(), distances.begin(), distances.end());
+                }
+            }
+        }
+        temp_graph.Freeze();
+        auto new_graph = std::make_unique<DirectedWeightedGraph<double>>(std::move(temp_graph));
+
+        std::unique_ptr<graph::RouterBase<double>> new_router = nullptr;
+        if (const auto *table_router = dynamic_cast<const graph::TableRouter<double> *>(router_.get())) {
+            new_router = std::make_unique<graph::Router<double>>(
+                    *new_graph, table_router->GetRoutesTable(), first_new_edge
+            );
+        } else if (const auto *all_pairs_router = GetAllPairsRouter()) {
+            new_router = std::make_unique<graph::Router<double>>(
+                    *new_graph, all_pairs_router->GetRoutesTable(), first_new_edge
+            );
+        } else if (const auto *fixed_point_router = GetFixedPointRouter()) {
+            std::optional<graph::RoutesTable<std::uint32_t>> routes_table;
+            if (const auto *fixed_table_router = dynamic_cast<const graph::TableRouter<std::uint32_t> *>(
+                    &fixed_point_router->GetRouter())) {
+                routes_table = fixed_table_router->GetRoutesTable();
+            } else if (const auto *fixed_all_pairs_router = GetFixedPointAllPairsRouter()) {
+                routes_table = fixed_all_pairs_router->GetRoutesTable();
+            }
+            if (routes_table) {
+                new_router = CreateFixedPointRouter(*new_graph, [&routes_table, first_new_edge](const auto &fixed_graph) {
+                    return std::make_unique<graph::Router<std::uint32_t>>(fixed_graph, *routes_table, first_new_edge);
+                });
+            }
+        }
+
+        search_router_ = nullptr;
+        router_ = std::move(new_router);
+        graph_ = std::move(new_graph);
+        search_router_ = std::make_unique<graph::DijkstraRouter<double>>(*graph_);
+        if (!router_) {
+            CreateRouter(transport_catalogue);
+        }
+    }
+
+    TransportRouter::BusEdges TransportRouter::BuildBusEdges(
+            const TransportCatalogue &transport_catalogue,
+            std::uint32_t bus_id,
+            VertexId first_bus_vertex
+    ) const {
+        if (routing_settings_.graph_model_ == GraphModel::BUS_CHAIN) {
+            return BuildBusChainEdges(transport_catalogue, bus_id, first_bus_vertex);
+        }
+
+        const Bus *bus = buses_[bus_id];
+        const auto &route = bus->bus_route_;
+        const size_t stops_count = route.size();
+
+        // Расстояния от начала маршрута до каждой остановки в прямом и обратном
+        // направлении: расстояние между i и j - разность двух сумм
+        std::vector<int> distances(stops_count, 0);
+        std::vector<int> back_distances(stops_count, 0);
+        std::vector<VertexId> vertex_ids(stops_count);
+        for (size_t k = 0; k < stops_count; ++k) {
+            vertex_ids[k] = stop_vertex_ids_.at(route[k]->stop_name_);
+            if (k > 0) {
+                distances[k] = distances[k - 1] + transport_catalogue.GetDistance(route[k - 1], route[k]);
+                back_distances[k] = back_distances[k - 1] + transport_catalogue.GetDistance(route[k], route[k - 1]);
+            }
+        }
+
+        const double velocity = routing_settings_.bus_velocity_ * km_to_min_in_hour;
+        const double boarding_time = GetBoardingTime(routing_settings_.bus_wait_time_);
+        const size_t stop_pair_count = stops_count < 2 ? 0 : stops_count * (stops_count - 1) / 2;
+        const size_t edge_count = bus->is_roundtrip_ ? stop_pair_count : stop_pair_count * 2;
+        BusEdges bus_edges;
+        bus_edges.edges.reserve(edge_count);
+        bus_edges.distances.reserve(edge_count);
+        for (size_t i = 0; i < stops_count; ++i) {
+            for (size_t j = i + 1; j < stops_count; ++j) {
+                bus_edges.edges.push_back(
+                        {
+                                bus_id,
+                                j - i,
+                                vertex_ids[i] + GetVerticesPerStop() - 1,
+                                vertex_ids[j],
+                                boarding_time + (distances[j] - distances[i]) / velocity
+                        }
+                );
+                bus_edges.distances.push_back(distances[j] - distances[i]);
+
+                if (!bus->is_roundtrip_) {
+                    bus_edges.edges.push_back(
                             {
-                                    bus->bus_name_,
-                                    static_cast<size_t>(j - i),
-                                    stop_ids_.at(final_stop->stop_name_) + 1,
-                                    stop_ids_.at(start_stop->stop_name_),
-                                    route_distance / (routing_settings_.bus_velocity_ * km_to_min_in_hour)
+                                    bus_id,
+                                    j - i,
+                                    vertex_ids[j] + GetVerticesPerStop() - 1,
+                                    vertex_ids[i],
+                                    boarding_time + (back_distances[j] - back_distances[i]) / velocity
                             }
                     );
-
-                    if (!bus->is_roundtrip_) {
-                        temp_graph.AddEdge(
-                                {
-                                        bus->bus_name_,
-                                        static_cast<size_t>(j - i),
-                                        stop_ids_.at(start_stop->stop_name_) + 1,
-                                        stop_ids_.at(final_stop->stop_name_),
-                                        back_route_distance / (routing_settings_.bus_velocity_ * km_to_min_in_hour)
-                                }
-                        );
-                    }
+                    bus_edges.distances.push_back(back_distances[j] - back_distances[i]);
                 }
             }
         }
-        graph_ = temp_graph;
-        router_ = std::make_unique<graph::Router<double>>(graph_);
+        return bus_edges;
+    }
+
+    // Автобус в каждом направлении - цепочка вершин по местам на маршруте.
+    // Посадка из вершины после ожидания и высадка в вершину прибытия ничего не
+    // стоят, время ожидания остаётся на ребре ожидания остановки
+    TransportRouter::BusEdges TransportRouter::BuildBusChainEdges(
+            const TransportCatalogue &transport_catalogue,
+            std::uint32_t bus_id,
+            VertexId first_bus_vertex
+    ) const {
+        const Bus *bus = buses_[bus_id];
+        const size_t stops_count = bus->bus_route_.size();
+        const double velocity = routing_settings_.bus_velocity_ * km_to_min_in_hour;
+        const double boarding_time = GetBoardingTime(routing_settings_.bus_wait_time_);
+
+        auto route = bus->bus_route_;
+        BusEdges bus_edges;
+        const size_t direction_count = bus->is_roundtrip_ ? 1 : 2;
+        const size_t edge_count = stops_count < 2 ? 0 : (stops_count - 1) * 3 * direction_count;
+        bus_edges.edges.reserve(edge_count);
+        bus_edges.distances.reserve(edge_count);
+        for (size_t direction = 0; direction < direction_count; ++direction) {
+            if (direction == 1) {
+                std::reverse(route.begin(), route.end());
+            }
+            const VertexId first_vertex = first_bus_vertex + direction * stops_count;
+            for (size_t k = 0; k + 1 < stops_count; ++k) {
+                const VertexId stop_vertex = stop_vertex_ids_.at(route[k]->stop_name_);
+                const VertexId next_stop_vertex = stop_vertex_ids_.at(route[k + 1]->stop_name_);
+                const int distance = transport_catalogue.GetDistance(route[k], route[k + 1]);
+
+                bus_edges.edges.push_back(
+                        {bus_id, 0, stop_vertex + GetVerticesPerStop() - 1, first_vertex + k, boarding_time}
+                );
+                bus_edges.distances.push_back(0);
+                bus_edges.edges.push_back({bus_id, 1, first_vertex + k, first_vertex + k + 1, distance / velocity});
+                bus_edges.distances.push_back(distance);
+                bus_edges.edges.push_back({bus_id, 0, first_vertex + k + 1, next_stop_vertex, 0.0});
+                bus_edges.distances.push_back(0);
+            }
+        }
+        return bus_edges;
+    }
+
+    size_t TransportRouter::GetBusVertexCount(const Bus *bus) const {
+        if (routing_settings_.graph_model_ != GraphModel::BUS_CHAIN) {
+            return 0;
+        }
+        return bus->is_roundtrip_ ? bus->bus_route_.size() : bus->bus_route_.size() * 2;
+    }
+
+    size_t TransportRouter::GetVerticesPerStop() const {
+        return routing_settings_.wait_on_boarding_ ? 1 : 2;
+    }
+
+    VertexId TransportRouter::GetArrivalVertex(size_t stop_id) const {
+        return stop_id * GetVerticesPerStop();
+    }
+
+    VertexId TransportRouter::GetDepartureVertex(size_t stop_id) const {
+        return stop_id * GetVerticesPerStop() + GetVerticesPerStop() - 1;
+    }
 
-        return graph_;
+    size_t TransportRouter::GetStopId(VertexId vertex_id) const {
+        return vertex_id / GetVerticesPerStop();
     }
 
-    optional <Router<double>::RouteInfo> TransportRouter::FindRoute(
+    bool TransportRouter::IsStopVertex(VertexId vertex_id) const {
+        return vertex_id < stops_.size() * GetVerticesPerStop();
+    }
+
+    bool TransportRouter::IsWaitEdge(const Edge<double> &edge) const {
+        return edge.quality == 0 && IsStopVertex(edge.from) && IsStopVertex(edge.to);
+    }
+
+    bool TransportRouter::IsBoardingEdge(const Edge<double> &edge) const {
+        return routing_settings_.wait_on_boarding_ && IsStopVertex(edge.from);
+    }
+
+    double TransportRouter::GetBoardingTime(double bus_wait_time) const {
+        return routing_settings_.wait_on_boarding_ ? bus_wait_time : 0.0;
+    }
+
+    // Рёбра маршрута в ответ. Посадка, перегоны и высадка в модели BUS_CHAIN
+    // сливаются в одну поездку, как ребро автобуса в модели STOP_PAIRS. Если
+    // ожидание входит в рёбра посадки, перед поездкой добавляется ребро
+    // ожидания, как в графе с двумя вершинами на остановку. Время поездки
+    // считается по расстоянию ребра, как вес ребра автобуса без ожидания
+    shared_ptr<const TransportRouter::Route> TransportRouter::MakeRoute(
+            const graph::RouteInfo<double> &route_info,
+            double bus_wait_time,
+            double velocity
+    ) const {
+        const bool has_edge_distances = edge_distances_.size() == graph_->GetEdgeCount();
+        auto route = make_shared<Route>(Route{route_info.weight, {}});
+        route->items.reserve(route_info.edges.size() * GetVerticesPerStop());
+        for (const EdgeId edge_id: route_info.edges) {
+            Edge<double> edge = graph_->GetEdge(edge_id);
+            if (IsWaitEdge(edge)) {
+                edge.weight = bus_wait_time;
+            } else if (has_edge_distances) {
+                edge.weight = edge_distances_[edge_id] / velocity;
+            } else {
+                edge.weight -= GetBoardingTime(bus_wait_time);
+            }
+            if (IsBoardingEdge(edge)) {
+                route->items.push_back(
+                        {
+                                static_cast<std::uint32_t>(GetStopId(edge.from)),
+                                0,
+                                edge.from,
+                                edge.from,
+                                bus_wait_time
+                        }
+                );
+            }
+            if (IsStopVertex(edge.from) || route->items.empty()) {
+                route->items.push_back(edge);
+                continue;
+            }
+            Edge<double> &ride = route->items.back();
+            ride.quality += edge.quality;
+            ride.to = edge.to;
+            ride.weight += edge.weight;
+        }
+        return route;
+    }
+
+    shared_ptr<const TransportRouter::Route> TransportRouter::FindRoute(
             string_view start_stop,
             string_view final_stop
     ) const {
-        return router_->BuildRoute(stop_ids_.at(std::string(start_stop)), stop_ids_.at(std::string(final_stop)));
+        const VertexId from = stop_vertex_ids_.at(start_stop);
+        const VertexId to = stop_vertex_ids_.at(final_stop);
+
+        if (auto cached_route = route_cache_->Find(from, to)) {
+            return std::move(*cached_route);
+        }
+        auto route = BuildRoute(from, to);
+        route_cache_->Insert(from, to, route);
+        return route;
+    }
+
+    std::vector<shared_ptr<const TransportRouter::Route>> TransportRouter::FindRoutes(
+            string_view start_stop,
+            const std::vector<string_view> &final_stops
+    ) const {
+        const VertexId from = stop_vertex_ids_.at(start_stop);
+
+        std::vector<shared_ptr<const Route>> routes(final_stops.size());
+        std::vector<size_t> missed_routes;
+        std::vector<VertexId> missed_vertices;
+        for (size_t i = 0; i < final_stops.size(); ++i) {
+            const VertexId to = stop_vertex_ids_.at(final_stops[i]);
+            if (auto cached_route = route_cache_->Find(from, to)) {
+                routes[i] = std::move(*cached_route);
+            } else {
+                missed_routes.push_back(i);
+                missed_vertices.push_back(to);
+            }
+        }
+
+        const auto *dijkstra_router = dynamic_cast<const graph::DijkstraRouter<double> *>(router_.get());
+        if (dijkstra_router && missed_vertices.size() > 1) {
+            const auto route_infos = dijkstra_router->BuildRoutes(from, missed_vertices);
+            for (size_t i = 0; i < missed_routes.size(); ++i) {
+                if (route_infos[i]) {
+                    routes[missed_routes[i]] = MakeRoute(
+                            *route_infos[i],
+                            routing_settings_.bus_wait_time_,
+                            routing_settings_.bus_velocity_ * km_to_min_in_hour
+                    );
+                }
+            }
+        } else {
+            for (size_t i = 0; i < missed_routes.size(); ++i) {
+                routes[missed_routes[i]] = BuildRoute(from, missed_vertices[i]);
+            }
+        }
+        for (size_t i = 0; i < missed_routes.size(); ++i) {
+            route_cache_->Insert(from, missed_vertices[i], routes[missed_routes[i]]);
+        }
+        return routes;
+    }
+
+    std::vector<shared_ptr<const TransportRouter::Route>> TransportRouter::FindRouteLegs(
+            const std::vector<string_view> &waypoints,
+            const RouteOverrides &overrides
+    ) const {
+        std::vector<shared_ptr<const Route>> legs(waypoints.empty() ? 0 : waypoints.size() - 1);
+        std::atomic<size_t> next_leg{0};
+        const auto find_legs = [this, &waypoints, &overrides, &legs, &next_leg]() {
+            for (size_t leg = next_leg++; leg < legs.size(); leg = next_leg++) {
+                legs[leg] = FindRoute(waypoints[leg], waypoints[leg + 1], overrides);
+            }
+        };
+
+        const RouterType router_type = routing_settings_.router_type_;
+        const bool is_indexed = !overrides.bus_wait_time_ && !overrides.bus_velocity_
+                                && (router_type == RouterType::FLOYD_WARSHALL
+                                    || router_type == RouterType::CONTRACTION_HIERARCHY
+                                    || router_type == RouterType::HUB_LABELS);
+        const size_t thread_count = is_indexed ? 1 : std::min<size_t>(
+                std::max(1u, std::thread::hardware_concurrency()),
+                legs.size()
+        );
+        std::vector<std::future<void>> workers;
+        for (size_t i = 1; i < thread_count; ++i) {
+            workers.push_back(std::async(std::launch::async, find_legs));
+        }
+        find_legs();
+        for (auto &worker: workers) {
+            worker.get();
+        }
+        return legs;
+    }
+
+    shared_ptr<const TransportRouter::Route> TransportRouter::FindRoute(
+            string_view start_stop,
+            string_view final_stop,
+            const RouteOverrides &overrides
+    ) const {
+        if (!overrides.bus_wait_time_ && !overrides.bus_velocity_) {
+            return FindRoute(start_stop, final_stop);
+        }
+        graph::NullSearchMonitor monitor;
+        return BuildRoute(stop_vertex_ids_.at(start_stop), stop_vertex_ids_.at(final_stop), overrides, monitor);
+    }
+
+    shared_ptr<const TransportRouter::Route> TransportRouter::FindRoute(
+            string_view start_stop,
+            string_view final_stop,
+            const RouteOverrides &overrides,
+            graph::SearchMonitor &monitor
+    ) const {
+        const VertexId from = stop_vertex_ids_.at(start_stop);
+        const VertexId to = stop_vertex_ids_.at(final_stop);
+        if (!overrides.bus_wait_time_ && !overrides.bus_velocity_) {
+            return BuildRoute(from, to, monitor);
+        }
+        return BuildRoute(from, to, overrides, monitor);
+    }
+
+    template<typename Monitor>
+    shared_ptr<const TransportRouter::Route> TransportRouter::BuildRoute(
+            VertexId from,
+            VertexId to,
+            const RouteOverrides &overrides,
+            Monitor &monitor
+    ) const {
+        const int bus_wait_time = overrides.bus_wait_time_.value_or(routing_settings_.bus_wait_time_);
+        const double bus_velocity = overrides.bus_velocity_.value_or(routing_settings_.bus_velocity_);
+        if (bus_wait_time < 0 || !(bus_velocity > 0)) {
+            throw std::invalid_argument("Bus wait time should be non-negative and bus velocity positive");
+        }
+        const double velocity = bus_velocity * km_to_min_in_hour;
+
+        if (raptor_router_) {
+            if (monitor.CheckDeadline()) {
+                return nullptr;
+            }
+            const auto journey = raptor_router_->BuildRoute(GetStopId(from), GetStopId(to), bus_wait_time, velocity);
+            return journey ? MakeRoute(*journey, bus_wait_time) : nullptr;
+        }
+
+        if (edge_distances_.size() != graph_->GetEdgeCount()) {
+            throw std::logic_error("The base has no edge distances, rebuild it to change settings per request");
+        }
+        const double boarding_time = GetBoardingTime(bus_wait_time);
+        const auto edge_weight = [this, bus_wait_time, boarding_time, velocity](EdgeId edge_id, double) {
+            const auto &edge = graph_->GetEdge(edge_id);
+            if (IsWaitEdge(edge)) {
+                return static_cast<double>(bus_wait_time);
+            }
+            const double ride_time = edge_distances_[edge_id] / velocity;
+            return IsBoardingEdge(edge) ? boarding_time + ride_time : ride_time;
+        };
+        const auto route_info = search_router_->BuildRoute(from, to, edge_weight, monitor);
+        return route_info ? MakeRoute(*route_info, bus_wait_time, velocity) : nullptr;
+    }
+
+    shared_ptr<const TransportRouter::Route> TransportRouter::BuildRoute(VertexId from, VertexId to) const {
+        if (raptor_router_) {
+            const auto journey = raptor_router_->BuildRoute(GetStopId(from), GetStopId(to));
+            return journey ? MakeRoute(*journey, routing_settings_.bus_wait_time_) : nullptr;
+        }
+
+        const auto route_info = router_->BuildRoute(from, to);
+        if (!route_info) {
+            return nullptr;
+        }
+        return MakeRoute(
+                *route_info,
+                routing_settings_.bus_wait_time_,
+                routing_settings_.bus_velocity_ * km_to_min_in_hour
+        );
+    }
+
+    shared_ptr<const TransportRouter::Route> TransportRouter::BuildRoute(
+            VertexId from,
+            VertexId to,
+            graph::SearchMonitor &monitor
+    ) const {
+        if (raptor_router_) {
+            return monitor.CheckDeadline() ? nullptr : BuildRoute(from, to);
+        }
+
+        const auto route_info = router_->BuildMonitoredRoute(from, to, monitor);
+        if (!route_info) {
+            return nullptr;
+        }
+        return MakeRoute(
+                *route_info,
+                routing_settings_.bus_wait_time_,
+                routing_settings_.bus_velocity_ * km_to_min_in_hour
+        );
+    }
+
+    // Поездки RAPTOR в виде рёбер ожидания и проезда, как в графе
+    shared_ptr<const TransportRouter::Route> TransportRouter::MakeRoute(
+            const RaptorRouter::Journey &journey,
+            double bus_wait_time
+    ) const {
+        auto route = make_shared<Route>(Route{journey.total_time, {}});
+        route->items.reserve(journey.legs.size() * 2);
+        for (const auto &leg: journey.legs) {
+            route->items.push_back(
+                    {
+                            leg.board_stop,
+                            0,
+                            GetArrivalVertex(leg.board_stop),
+                            GetDepartureVertex(leg.board_stop),
+                            bus_wait_time
+                    }
+            );
+            route->items.push_back(
+                    {
+                            leg.bus_id,
+                            leg.span_count,
+                            GetDepartureVertex(leg.board_stop),
+                            GetArrivalVertex(leg.alight_stop),
+                            leg.ride_time
+                    }
+            );
+        }
+        return route;
+    }
+
+    std::vector<TransportRouter::ReachableStop> TransportRouter::FindReachableStops(
+            string_view start_stop,
+            double max_time
+    ) const {
+        const VertexId from = stop_vertex_ids_.at(start_stop);
+
+        std::vector<ReachableStop> reachable_stops;
+        if (raptor_router_) {
+            for (const auto &[stop_id, time]: raptor_router_->BuildReachable(GetStopId(from), max_time)) {
+                reachable_stops.push_back({stops_[stop_id], time});
+            }
+        } else {
+            // Время прибытия на остановку - расстояние до её вершины ожидания
+            for (const auto &[vertex_id, time]: search_router_->BuildReachable(from, max_time)) {
+                if (IsStopVertex(vertex_id) && vertex_id == GetArrivalVertex(GetStopId(vertex_id))) {
+                    reachable_stops.push_back({stops_[GetStopId(vertex_id)], time});
+                }
+            }
+        }
+        std::sort(reachable_stops.begin(), reachable_stops.end(), [](const auto &lhs, const auto &rhs) {
+            return lhs.time < rhs.time || (!(rhs.time < lhs.time) && lhs.stop->stop_name_ < rhs.stop->stop_name_);
+        });
+        return reachable_stops;
+    }
+
+    std::vector<std::vector<std::optional<double>>> TransportRouter::FindTravelTimes(
+            const std::vector<std::string_view> &sources,
+            const std::vector<std::string_view> &targets
+    ) const {
+        std::vector<VertexId> source_vertices;
+        source_vertices.reserve(sources.size());
+        for (const string_view stop_name: sources) {
+            source_vertices.push_back(stop_vertex_ids_.at(stop_name));
+        }
+        std::vector<VertexId> target_vertices;
+        target_vertices.reserve(targets.size());
+        for (const string_view stop_name: targets) {
+            target_vertices.push_back(stop_vertex_ids_.at(stop_name));
+        }
+
+        const auto find_row = [this, &target_vertices](VertexId from) {
+            if (!raptor_router_) {
+                return search_router_->BuildDistances(from, target_vertices);
+            }
+            std::vector<std::optional<double>> arrivals(stops_.size());
+            for (const auto &[stop_id, time]: raptor_router_->BuildReachable(
+                    GetStopId(from),
+                    numeric_limits<double>::infinity()
+            )) {
+                arrivals[stop_id] = time;
+            }
+            std::vector<std::optional<double>> row;
+            row.reserve(target_vertices.size());
+            for (const VertexId to: target_vertices) {
+                row.push_back(arrivals[GetStopId(to)]);
+            }
+            return row;
+        };
+
+        std::vector<std::vector<std::optional<double>>> travel_times(source_vertices.size());
+        std::atomic<size_t> next_row{0};
+        const auto find_rows = [&source_vertices, &travel_times, &next_row, &find_row]() {
+            for (size_t row = next_row++; row < travel_times.size(); row = next_row++) {
+                travel_times[row] = find_row(source_vertices[row]);
+            }
+        };
+        const size_t thread_count = std::min<size_t>(
+                std::max(1u, std::thread::hardware_concurrency()),
+                travel_times.size()
+        );
+        std::vector<std::future<void>> workers;
+        for (size_t i = 1; i < thread_count; ++i) {
+            workers.push_back(std::async(std::launch::async, find_rows));
+        }
+        find_rows();
+        for (auto &worker: workers) {
+            worker.get();
+        }
+        return travel_times;
     }
 
     const Edge<double> &TransportRouter::GetGraphEdge(const EdgeId &edge_id) const {
-        return graph_.GetEdge(edge_id);
+        return graph_->GetEdge(edge_id);
+    }
+
+    std::string_view TransportRouter::GetEdgeName(const Edge<double> &edge) const {
+        if (edge.quality == 0) {
+            return stops_.at(edge.name_id)->stop_name_;
+        }
+        return buses_.at(edge.name_id)->bus_name_;
     }
 
     TransportRouter::RoutingSettings TransportRouter::GetRoutingSettings() const {
@@ -94,16 +709,385 @@ namespace transport_router {
         return stop_ids_;
     }
 
-    graph::DirectedWeightedGraph<double> TransportRouter::GetGraph() const {
-        return graph_;
+    const std::vector<int> &TransportRouter::GetEdgeDistances() const {
+        return edge_distances_;
+    }
+
+    void TransportRouter::SetEdgeDistances(std::vector<int> edge_distances) {
+        if (!edge_distances.empty() && edge_distances.size() != graph_->GetEdgeCount()) {
+            throw std::invalid_argument("Edge distances don't match the graph");
+        }
+        edge_distances_ = std::move(edge_distances);
+    }
+
+    const graph::DirectedWeightedGraph<double> &TransportRouter::GetGraph() const {
+        return *graph_;
+    }
+
+    const graph::Router<double> *TransportRouter::GetAllPairsRouter() const {
+        return dynamic_cast<const graph::Router<double> *>(router_.get());
+    }
+
+    const graph::ContractionHierarchyRouter<double> *TransportRouter::GetContractionHierarchyRouter() const {
+        return dynamic_cast<const graph::ContractionHierarchyRouter<double> *>(router_.get());
+    }
+
+    const graph::HubLabelRouter<double> *TransportRouter::GetHubLabelRouter() const {
+        return dynamic_cast<const graph::HubLabelRouter<double> *>(router_.get());
+    }
+
+    const RaptorRouter *TransportRouter::GetRaptorRouter() const {
+        return raptor_router_.get();
+    }
+
+    const TransportRouter::FixedPointRouter *TransportRouter::GetFixedPointRouter() const {
+        return dynamic_cast<const FixedPointRouter *>(router_.get());
+    }
+
+    const graph::OverlayRouter<double> *TransportRouter::GetOverlayRouter() const {
+        return dynamic_cast<const graph::OverlayRouter<double> *>(router_.get());
+    }
+
+    const graph::Router<std::uint32_t> *TransportRouter::GetFixedPointAllPairsRouter() const {
+        const auto *fixed_point_router = GetFixedPointRouter();
+        return fixed_point_router
+               ? dynamic_cast<const graph::Router<std::uint32_t> *>(&fixed_point_router->GetRouter())
+               : nullptr;
+    }
+
+    std::optional<size_t> TransportRouter::GetSettledVertexCount() const {
+        if (const auto *dijkstra_router = dynamic_cast<const graph::DijkstraRouter<double> *>(router_.get())) {
+            return dijkstra_router->GetSettledVertexCount();
+        }
+        if (const auto *astar_router = dynamic_cast<const graph::AStarRouter<double> *>(router_.get())) {
+            return astar_router->GetSettledVertexCount();
+        }
+        if (const auto *overlay_router = GetOverlayRouter()) {
+            return overlay_router->GetSettledVertexCount();
+        }
+        if (const auto *fixed_point_router = GetFixedPointRouter()) {
+            if (const auto *dijkstra_router = dynamic_cast<const graph::DijkstraRouter<std::uint32_t> *>(
+                    &fixed_point_router->GetRouter())) {
+                return dijkstra_router->GetSettledVertexCount();
+            }
+        }
+        return nullopt;
+    }
+
+    size_t TransportRouter::GetRouteCacheHitCount() const {
+        return route_cache_->GetHitCount();
+    }
+
+    size_t TransportRouter::GetRouteCacheMissCount() const {
+        return route_cache_->GetMissCount();
     }
 
     void TransportRouter::FillRouter(
+            const TransportCatalogue &transport_catalogue,
             const graph::DirectedWeightedGraph<double> graph,
             const std::map<std::string, graph::VertexId> stop_ids
     ) {
-        graph_ = graph;
-        stop_ids_ = stop_ids;
-        router_ = std::make_unique<graph::Router<double>>(graph_);
+        IndexCatalogue(transport_catalogue);
+        SetGraph(graph, stop_ids);
+        CreateRouter(transport_catalogue);
+    }
+
+    void TransportRouter::FillRouter(
+            const TransportCatalogue &transport_catalogue,
+            const graph::DirectedWeightedGraph<double> graph,
+            const std::map<std::string, graph::VertexId> stop_ids,
+            graph::RoutesTable<double> routes_table
+    ) {
+        IndexCatalogue(transport_catalogue);
+        SetGraph(graph, stop_ids);
+        router_ = std::make_unique<graph::TableRouter<double>>(*graph_, std::move(routes_table));
+    }
+
+    void TransportRouter::FillRouter(
+            const TransportCatalogue &transport_catalogue,
+            const graph::DirectedWeightedGraph<double> graph,
+            const std::map<std::string, graph::VertexId> stop_ids,
+            graph::RoutesTable<std::uint32_t> routes_table
+    ) {
+        IndexCatalogue(transport_catalogue);
+        SetGraph(graph, stop_ids);
+        router_ = CreateFixedPointRouter(*graph_, [&routes_table](const auto &fixed_graph) {
+            return std::make_unique<graph::TableRouter<std::uint32_t>>(fixed_graph, std::move(routes_table));
+        });
+    }
+
+    void TransportRouter::FillRouter(
+            const TransportCatalogue &transport_catalogue,
+            const graph::DirectedWeightedGraph<double> graph,
+            const std::map<std::string, graph::VertexId> stop_ids,
+            graph::ContractionHierarchyRouter<double>::Hierarchy hierarchy
+    ) {
+        IndexCatalogue(transport_catalogue);
+        SetGraph(graph, stop_ids);
+        router_ = std::make_unique<graph::ContractionHierarchyRouter<double>>(*graph_, std::move(hierarchy));
+    }
+
+    void TransportRouter::FillRouter(
+            const TransportCatalogue &transport_catalogue,
+            const graph::DirectedWeightedGraph<double> graph,
+            const std::map<std::string, graph::VertexId> stop_ids,
+            graph::HubLabelRouter<double>::Index hub_labels
+    ) {
+        IndexCatalogue(transport_catalogue);
+        SetGraph(graph, stop_ids);
+        router_ = std::make_unique<graph::HubLabelRouter<double>>(*graph_, std::move(hub_labels));
+    }
+
+    void TransportRouter::FillRouter(
+            const TransportCatalogue &transport_catalogue,
+            const graph::DirectedWeightedGraph<double> graph,
+            const std::map<std::string, graph::VertexId> stop_ids,
+            graph::OverlayShortcuts<double> shortcuts
+    ) {
+        IndexCatalogue(transport_catalogue);
+        SetGraph(graph, stop_ids);
+        router_ = std::make_unique<graph::OverlayRouter<double>>(*graph_, std::move(shortcuts));
+    }
+
+    void TransportRouter::IndexCatalogue(const TransportCatalogue &transport_catalogue) {
+        // Маршруты из кэша найдены в старом графе
+        route_cache_->Clear();
+        stops_.clear();
+        buses_.clear();
+        for (const auto &[stop_name, stop]: transport_catalogue.GetSortedStops()) {
+            stops_.push_back(stop);
+        }
+        for (const auto &[bus_name, bus]: transport_catalogue.GetSortedBuses()) {
+            buses_.push_back(bus);
+        }
+    }
+
+    void TransportRouter::OrderStops() {
+        if (stops_.empty()) {
+            return;
+        }
+        switch (routing_settings_.vertex_order_) {
+            case VertexOrder::NAME:
+                break;
+            case VertexOrder::HILBERT: {
+                geo::Coordinates min = stops_.front()->coordinates_;
+                geo::Coordinates max = min;
+                for (const Stop *stop: stops_) {
+                    min.lat = std::min(min.lat, stop->coordinates_.lat);
+                    min.lng = std::min(min.lng, stop->coordinates_.lng);
+                    max.lat = std::max(max.lat, stop->coordinates_.lat);
+                    max.lng = std::max(max.lng, stop->coordinates_.lng);
+                }
+                std::vector<std::pair<std::uint64_t, const Stop *>> indexed_stops;
+                indexed_stops.reserve(stops_.size());
+                for (const Stop *stop: stops_) {
+                    indexed_stops.emplace_back(geo::ComputeHilbertIndex(stop->coordinates_, min, max), stop);
+                }
+                // Остановки в одной клетке кривой остаются в алфавитном порядке
+                std::stable_sort(indexed_stops.begin(), indexed_stops.end(), [](const auto &lhs, const auto &rhs) {
+                    return lhs.first < rhs.first;
+                });
+                for (size_t i = 0; i < stops_.size(); ++i) {
+                    stops_[i] = indexed_stops[i].second;
+                }
+                break;
+            }
+            case VertexOrder::BFS: {
+                // Соседи остановки - соседние с ней остановки маршрутов, в
+                // алфавитном порядке; обход начинается с первой по алфавиту
+                // ещё не пройденной остановки
+                std::unordered_map<const Stop *, size_t> name_order;
+                for (size_t i = 0; i < stops_.size(); ++i) {
+                    name_order[stops_[i]] = i;
+                }
+                std::vector<std::vector<size_t>> neighbours(stops_.size());
+                for (const Bus *bus: buses_) {
+                    for (size_t i = 1; i < bus->bus_route_.size(); ++i) {
+                        const size_t from = name_order.at(bus->bus_route_[i - 1]);
+                        const size_t to = name_order.at(bus->bus_route_[i]);
+                        neighbours[from].push_back(to);
+                        neighbours[to].push_back(from);
+                    }
+                }
+                for (auto &stop_neighbours: neighbours) {
+                    std::sort(stop_neighbours.begin(), stop_neighbours.end());
+                    stop_neighbours.erase(
+                            std::unique(stop_neighbours.begin(), stop_neighbours.end()),
+                            stop_neighbours.end()
+                    );
+                }
+
+                std::vector<const Stop *> ordered_stops;
+                ordered_stops.reserve(stops_.size());
+                std::vector<char> visited(stops_.size(), false);
+                for (size_t root = 0; root < stops_.size(); ++root) {
+                    if (visited[root]) {
+                        continue;
+                    }
+                    visited[root] = true;
+                    size_t head = ordered_stops.size();
+                    ordered_stops.push_back(stops_[root]);
+                    for (; head < ordered_stops.size(); ++head) {
+                        for (const size_t neighbour: neighbours[name_order.at(ordered_stops[head])]) {
+                            if (!visited[neighbour]) {
+                                visited[neighbour] = true;
+                                ordered_stops.push_back(stops_[neighbour]);
+                            }
+                        }
+                    }
+                }
+                stops_ = std::move(ordered_stops);
+                break;
+            }
+        }
+    }
+
+    void TransportRouter::RestoreStopOrder() {
+        std::vector<std::pair<VertexId, const Stop *>> numbered_stops;
+        numbered_stops.reserve(stops_.size());
+        for (const Stop *stop: stops_) {
+            const auto it = stop_vertex_ids_.find(stop->stop_name_);
+            if (it == stop_vertex_ids_.end()) {
+                throw std::invalid_argument("Stops can't be added without rebuilding the graph");
+            }
+            numbered_stops.emplace_back(it->second, stop);
+        }
+        std::sort(numbered_stops.begin(), numbered_stops.end());
+        for (size_t i = 0; i < stops_.size(); ++i) {
+            stops_[i] = numbered_stops[i].second;
+        }
+    }
+
+    void TransportRouter::SetGraph(
+            graph::DirectedWeightedGraph<double> graph,
+            std::map<std::string, graph::VertexId> stop_ids
+    ) {
+        graph.Freeze();
+        graph_ = std::make_unique<DirectedWeightedGraph<double>>(std::move(graph));
+        edge_distances_.clear();
+        search_router_ = std::make_unique<graph::DijkstraRouter<double>>(*graph_);
+        stop_ids_ = std::move(stop_ids);
+        IndexStopIds();
+        RestoreStopOrder();
+    }
+
+    void TransportRouter::IndexStopIds() {
+        stop_vertex_ids_.clear();
+        stop_vertex_ids_.reserve(stop_ids_.size());
+        for (const auto &[stop_name, vertex_id]: stop_ids_) {
+            stop_vertex_ids_.emplace(stop_name, vertex_id);
+        }
+    }
+
+    std::vector<geo::Coordinates> TransportRouter::GetVertexCoordinates() const {
+        std::vector<geo::Coordinates> coordinates(graph_->GetVertexCount());
+        for (size_t stop_id = 0; stop_id < stops_.size(); ++stop_id) {
+            coordinates[GetArrivalVertex(stop_id)] = stops_[stop_id]->coordinates_;
+            coordinates[GetDepartureVertex(stop_id)] = stops_[stop_id]->coordinates_;
+        }
+        // Вершины автобусов стоят там же, где остановки их посадки и высадки
+        for (EdgeId edge_id = 0; edge_id < graph_->GetEdgeCount(); ++edge_id) {
+            const auto &edge = graph_->GetEdge(edge_id);
+            if (IsStopVertex(edge.from) && !IsStopVertex(edge.to)) {
+                coordinates[edge.to] = coordinates[edge.from];
+            } else if (!IsStopVertex(edge.from) && IsStopVertex(edge.to)) {
+                coordinates[edge.from] = coordinates[edge.to];
+            }
+        }
+        return coordinates;
+    }
+
+    // Нижняя оценка времени на метр расстояния по сфере для A*. Дорожные
+    // расстояния в данных бывают и короче сферических, поэтому оценка
+    // умножается на наименьшее их отношение по всем перегонам: по неравенству
+    // треугольника она остаётся допустимой и для рёбер через несколько перегонов
+    double TransportRouter::ComputeMinutesPerMeterBound(const TransportCatalogue &transport_catalogue) const {
+        // Запас на погрешность geo::ComputeDistance
+        static constexpr double safety_factor = 0.99;
+
+        std::optional<double> min_ratio;
+        for (const Bus *bus: buses_) {
+            const auto &route = bus->bus_route_;
+            for (size_t k = 1; k < route.size(); ++k) {
+                const double geo_distance = geo::ComputeDistance(route[k - 1]->coordinates_, route[k]->coordinates_);
+                if (geo_distance <= 0) {
+                    continue;
+                }
+                for (const int road_distance: {transport_catalogue.GetDistance(route[k - 1], route[k]),
+                                               transport_catalogue.GetDistance(route[k], route[k - 1])}) {
+                    const double ratio = road_distance / geo_distance;
+                    if (!min_ratio || ratio < *min_ratio) {
+                        min_ratio = ratio;
+                    }
+                }
+            }
+        }
+        return min_ratio.value_or(0.0) * safety_factor / (routing_settings_.bus_velocity_ * km_to_min_in_hour);
+    }
+
+    std::unique_ptr<TransportRouter::FixedPointRouter> TransportRouter::CreateFixedPointRouter(
+            const DirectedWeightedGraph<double> &graph,
+            const FixedPointRouter::RouterFactory &create_router
+    ) const {
+        return std::make_unique<FixedPointRouter>(graph, fixed_point_scale, create_router);
+    }
+
+    void TransportRouter::CreateRouter(const TransportCatalogue &transport_catalogue) {
+        raptor_router_ = nullptr;
+        const bool fixed_point_weights = routing_settings_.fixed_point_weights_;
+        switch (routing_settings_.router_type_) {
+            case RouterType::FLOYD_WARSHALL:
+                if (fixed_point_weights) {
+                    router_ = CreateFixedPointRouter(*graph_, [](const auto &fixed_graph) {
+                        return std::make_unique<graph::Router<std::uint32_t>>(fixed_graph);
+                    });
+                } else {
+                    router_ = std::make_unique<graph::Router<double>>(*graph_);
+                }
+                break;
+            case RouterType::DIJKSTRA:
+                if (fixed_point_weights) {
+                    router_ = CreateFixedPointRouter(*graph_, [](const auto &fixed_graph) {
+                        return std::make_unique<graph::DijkstraRouter<std::uint32_t>>(fixed_graph);
+                    });
+                } else {
+                    router_ = std::make_unique<graph::DijkstraRouter<double>>(*graph_);
+                }
+                break;
+            case RouterType::CONTRACTION_HIERARCHY:
+                router_ = std::make_unique<graph::ContractionHierarchyRouter<double>>(*graph_);
+                break;
+            case RouterType::HUB_LABELS:
+                router_ = std::make_unique<graph::HubLabelRouter<double>>(*graph_);
+                break;
+            case RouterType::A_STAR:
+                router_ = std::make_unique<graph::AStarRouter<double>>(
+                        *graph_,
+                        GetVertexCoordinates(),
+                        ComputeMinutesPerMeterBound(transport_catalogue)
+                );
+                break;
+            case RouterType::CELL_OVERLAY: {
+                auto partition = std::make_shared<const graph::GraphPartition>(
+                        *graph_,
+                        graph::PartitionByHilbertCurve(GetVertexCoordinates(), routing_settings_.overlay_cell_size_)
+                );
+                router_ = std::make_unique<graph::OverlayRouter<double>>(
+                        *graph_,
+                        graph::OverlayRouter<double>::ComputeShortcuts(*graph_, std::move(partition))
+                );
+                break;
+            }
+            case RouterType::RAPTOR:
+                router_ = nullptr;
+                raptor_router_ = std::make_unique<RaptorRouter>(
+                        transport_catalogue,
+                        stops_,
+                        buses_,
+                        static_cast<double>(routing_settings_.bus_wait_time_),
+                        routing_settings_.bus_velocity_ * km_to_min_in_hour
+                );
+                break;
+        }
     }
 }
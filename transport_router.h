@@ -1,10 +1,24 @@
 #pragma once
 
 #include "router.h"
+#include "dijkstra_router.h"
+#include "astar_router.h"
+#include "routes_table.h"
+#include "fixed_point_router.h"
+#include "overlay_router.h"
+#include "contraction_hierarchy.h"
+#include "hub_labels.h"
+#include "raptor_router.h"
+#include "route_cache.h"
 #include "transport_catalogue.h"
 
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace transport_router {
     using namespace graph;
@@ -12,40 +26,335 @@ namespace transport_router {
 
     class TransportRouter {
     public:
+        enum class RouterType {
+            FLOYD_WARSHALL,
+            DIJKSTRA,
+            CONTRACTION_HIERARCHY,
+            HUB_LABELS,
+            RAPTOR,
+            A_STAR,
+            CELL_OVERLAY,
+        };
+
+        // Модель графа. STOP_PAIRS - ребро автобуса на каждую пару остановок
+        // маршрута, O(k^2) рёбер на маршрут из k остановок. BUS_CHAIN - вершина
+        // на каждое место автобуса на маршруте, рёбра перегонов между соседними
+        // местами и рёбра посадки и высадки, O(k) рёбер
+        enum class GraphModel {
+            STOP_PAIRS,
+            BUS_CHAIN,
+        };
+
+        // Порядок номеров вершин остановок. NAME - по алфавиту, HILBERT - вдоль
+        // кривой Гильберта по координатам остановок, BFS - обходом в ширину по
+        // перегонам автобусов. Близкие остановки получают близкие номера, и
+        // поиски и строки таблиц реже промахиваются мимо кэша
+        enum class VertexOrder {
+            NAME,
+            HILBERT,
+            BFS,
+        };
+
         struct RoutingSettings {
             int bus_wait_time_ = 0;
             double bus_velocity_ = 0;
+            RouterType router_type_ = RouterType::FLOYD_WARSHALL;
+            // Число маршрутов в кэше найденных маршрутов, 0 - кэш выключен
+            size_t route_cache_size_ = 0;
+            GraphModel graph_model_ = GraphModel::STOP_PAIRS;
+            // Ожидание входит в рёбра посадки на автобус, и у остановки одна
+            // вершина вместо вершин прибытия и отправления
+            bool wait_on_boarding_ = false;
+            // floyd_warshall и dijkstra ищут маршруты по весам в целых
+            // миллисекундах (uint32_t) вместо минут в double
+            bool fixed_point_weights_ = false;
+            VertexOrder vertex_order_ = VertexOrder::NAME;
+            // Число вершин в ячейке разбиения cell_overlay
+            size_t overlay_cell_size_ = 256;
+        };
+
+        using FixedPointRouter = graph::FixedPointRouter<double, std::uint32_t>;
+
+        // Маршрут как последовательность рёбер ожидания и поездок. Движки по
+        // графу берут рёбра из графа, RAPTOR строит их сам
+        struct Route {
+            double total_time = 0;
+            std::vector<Edge<double>> items;
+        };
+
+        // Настройки отдельного запроса Route вместо общих
+        struct RouteOverrides {
+            std::optional<int> bus_wait_time_;
+            std::optional<double> bus_velocity_;
+        };
+
+        struct ReachableStop {
+            const Stop *stop;
+            double time;
         };
     private:
         static constexpr double km_to_min_in_hour = 1000.0 / 60.0;
+        // Единиц целого веса в минуте: миллисекунды
+        static constexpr double fixed_point_scale = 60000.0;
 
         RoutingSettings routing_settings_{};
-        DirectedWeightedGraph<double> graph_{};
+        std::unique_ptr<DirectedWeightedGraph<double>> graph_ = std::make_unique<DirectedWeightedGraph<double>>();
         std::map<std::string, graph::VertexId> stop_ids_{};
-        std::unique_ptr<graph::Router<double>> router_ = nullptr;
+        // Ключи ссылаются на имена в stop_ids_
+        std::unordered_map<std::string_view, graph::VertexId> stop_vertex_ids_{};
+        // Остановки и автобусы в порядке их id в рёбрах графа
+        std::vector<const Stop *> stops_{};
+        std::vector<const Bus *> buses_{};
+        std::unique_ptr<graph::RouterBase<double>> router_ = nullptr;
+        std::unique_ptr<RaptorRouter> raptor_router_ = nullptr;
+        // Поиск по графу без предрасчёта: запросы Reachable и Matrix и
+        // маршруты с настройками запроса
+        std::unique_ptr<graph::DijkstraRouter<double>> search_router_ = nullptr;
+        // Расстояние в метрах для каждого ребра автобуса, 0 для рёбер ожидания,
+        // посадки и высадки:
+        // по нему вес ребра считается при любой скорости
+        std::vector<int> edge_distances_{};
+        // Пустой указатель в кэше означает, что маршрута нет
+        std::unique_ptr<RouteCache<std::shared_ptr<const Route>>> route_cache_;
     public:
 
-        TransportRouter(RoutingSettings routing_settings) : routing_settings_(routing_settings) {}
+        TransportRouter(RoutingSettings routing_settings)
+                : routing_settings_(routing_settings),
+                  route_cache_(std::make_unique<RouteCache<std::shared_ptr<const Route>>>(
+                          routing_settings.route_cache_size_
+                  )) {}
 
         const DirectedWeightedGraph<double> &BuildGraph(const TransportCatalogue &transport_catalogue);
 
-        std::optional<Router<double>::RouteInfo> FindRoute(
+        // Дописывает в граф рёбра автобусов каталога, которых в нём ещё нет,
+        // не перестраивая остальной граф. Остановки и прежние автобусы должны
+        // остаться теми же. Таблица всех пар досчитывается через вершины
+        // посадки новых автобусов, индексы остальных движков строятся заново
+        void AddBuses(const TransportCatalogue &transport_catalogue);
+
+        // Пустой указатель, если маршрута нет
+        std::shared_ptr<const Route> FindRoute(
                 std::string_view start_stop,
                 std::string_view final_stop
         ) const;
 
+        // Маршруты от start_stop до каждой из final_stops в том же порядке.
+        // Движок dijkstra ищет маршруты, которых нет в кэше, одним поиском,
+        // остальные - по одному
+        std::vector<std::shared_ptr<const Route>> FindRoutes(
+                std::string_view start_stop,
+                const std::vector<std::string_view> &final_stops
+        ) const;
+
+        // Маршруты между соседними остановками waypoints, по одному на участок.
+        // Участки ищутся параллельно, движки с таблицами и индексами отвечают
+        // на них по очереди
+        std::vector<std::shared_ptr<const Route>> FindRouteLegs(
+                const std::vector<std::string_view> &waypoints,
+                const RouteOverrides &overrides = {}
+        ) const;
+
+        // Остановки, до которых можно доехать от start_stop не дольше чем за
+        // max_time, по возрастанию времени
+        std::vector<ReachableStop> FindReachableStops(std::string_view start_stop, double max_time) const;
+
+        // Матрица времени в пути: строка на каждую остановку sources, столбец
+        // на каждую остановку targets. Один поиск на источник, источники
+        // обрабатываются параллельно
+        std::vector<std::vector<std::optional<double>>> FindTravelTimes(
+                const std::vector<std::string_view> &sources,
+                const std::vector<std::string_view> &targets
+        ) const;
+
+        // Маршрут при других времени ожидания или скорости. Таблицы и индексы
+        // движков посчитаны для общих настроек, поэтому поиск идёт по графу
+        std::shared_ptr<const Route> FindRoute(
+                std::string_view start_stop,
+                std::string_view final_stop,
+                const RouteOverrides &overrides
+        ) const;
+
+        // Маршрут под наблюдением monitor: поиск идёт мимо кэша, чтобы
+        // monitor видел работу движка. Если срок monitor вышел, маршрута нет
+        // и monitor.IsExpired(). Пошагово считают работу dijkstra, a_star и cell_overlay,
+        // а также поиск с настройками запроса
+        std::shared_ptr<const Route> FindRoute(
+                std::string_view start_stop,
+                std::string_view final_stop,
+                const RouteOverrides &overrides,
+                graph::SearchMonitor &monitor
+        ) const;
+
         const Edge<double> &GetGraphEdge(const EdgeId &edge_id) const;
 
+        std::string_view GetEdgeName(const Edge<double> &edge) const;
+
         RoutingSettings GetRoutingSettings() const;
 
-        graph::DirectedWeightedGraph<double> GetGraph() const;
+        const graph::DirectedWeightedGraph<double> &GetGraph() const;
 
         std::map<std::string, graph::VertexId> GetStopIds() const;
 
+        const std::vector<int> &GetEdgeDistances() const;
+
+        // Расстояния рёбер графа из базы; в базах старого формата их нет
+        void SetEdgeDistances(std::vector<int> edge_distances);
+
+        const graph::Router<double> *GetAllPairsRouter() const;
+
+        const graph::ContractionHierarchyRouter<double> *GetContractionHierarchyRouter() const;
+
+        const graph::HubLabelRouter<double> *GetHubLabelRouter() const;
+
+        const RaptorRouter *GetRaptorRouter() const;
+
+        const FixedPointRouter *GetFixedPointRouter() const;
+
+        const graph::Router<std::uint32_t> *GetFixedPointAllPairsRouter() const;
+
+        const graph::OverlayRouter<double> *GetOverlayRouter() const;
+
+        // Число вершин, просмотренных всеми запросами, для движков, которые его считают
+        std::optional<size_t> GetSettledVertexCount() const;
+
+        size_t GetRouteCacheHitCount() const;
+
+        size_t GetRouteCacheMissCount() const;
+
         void FillRouter(
+                const TransportCatalogue &transport_catalogue,
                 const graph::DirectedWeightedGraph<double> graph,
                 const std::map<std::string, graph::VertexId> stop_ids
         );
 
+        void FillRouter(
+                const TransportCatalogue &transport_catalogue,
+                const graph::DirectedWeightedGraph<double> graph,
+                const std::map<std::string, graph::VertexId> stop_ids,
+                graph::RoutesTable<double> routes_table
+        );
+
+        void FillRouter(
+                const TransportCatalogue &transport_catalogue,
+                const graph::DirectedWeightedGraph<double> graph,
+                const std::map<std::string, graph::VertexId> stop_ids,
+                graph::RoutesTable<std::uint32_t> routes_table
+        );
+
+        void FillRouter(
+                const TransportCatalogue &transport_catalogue,
+                const graph::DirectedWeightedGraph<double> graph,
+                const std::map<std::string, graph::VertexId> stop_ids,
+                graph::ContractionHierarchyRouter<double>::Hierarchy hierarchy
+        );
+
+        void FillRouter(
+                const TransportCatalogue &transport_catalogue,
+                const graph::DirectedWeightedGraph<double> graph,
+                const std::map<std::string, graph::VertexId> stop_ids,
+                graph::HubLabelRouter<double>::Index hub_labels
+        );
+
+        void FillRouter(
+                const TransportCatalogue &transport_catalogue,
+                const graph::DirectedWeightedGraph<double> graph,
+                const std::map<std::string, graph::VertexId> stop_ids,
+                graph::OverlayShortcuts<double> shortcuts
+        );
+
+    private:
+        void IndexCatalogue(const TransportCatalogue &transport_catalogue);
+
+        // Переставляет stops_ в порядке vertex_order_: от места остановки в
+        // stops_ зависят номера её вершин
+        void OrderStops();
+
+        // Переставляет stops_ по номерам вершин из stop_ids_, например из базы
+        void RestoreStopOrder();
+
+        // Рёбра автобуса и проезжаемые ими расстояния
+        struct BusEdges {
+            std::vector<Edge<double>> edges;
+            std::vector<int> distances;
+        };
+
+        // Вершины автобуса в модели BUS_CHAIN нумеруются с first_bus_vertex
+        BusEdges BuildBusEdges(
+                const TransportCatalogue &transport_catalogue,
+                std::uint32_t bus_id,
+                graph::VertexId first_bus_vertex
+        ) const;
+
+        BusEdges BuildBusChainEdges(
+                const TransportCatalogue &transport_catalogue,
+                std::uint32_t bus_id,
+                graph::VertexId first_bus_vertex
+        ) const;
+
+        // Число вершин графа, которые занимает автобус кроме вершин остановок
+        size_t GetBusVertexCount(const Bus *bus) const;
+
+        // Вершины остановок идут первыми, по одной или по две на остановку:
+        // прибытие и отправление после ожидания. Дальше идут вершины автобусов
+        size_t GetVerticesPerStop() const;
+
+        graph::VertexId GetArrivalVertex(size_t stop_id) const;
+
+        graph::VertexId GetDepartureVertex(size_t stop_id) const;
+
+        size_t GetStopId(graph::VertexId vertex_id) const;
+
+        bool IsStopVertex(graph::VertexId vertex_id) const;
+
+        bool IsWaitEdge(const Edge<double> &edge) const;
+
+        // Ребро посадки, в вес которого входит ожидание
+        bool IsBoardingEdge(const Edge<double> &edge) const;
+
+        // Часть ожидания, которая входит в вес рёбер посадки
+        double GetBoardingTime(double bus_wait_time) const;
+
+        void SetGraph(
+                graph::DirectedWeightedGraph<double> graph,
+                std::map<std::string, graph::VertexId> stop_ids
+        );
+
+        void IndexStopIds();
+
+        std::shared_ptr<const Route> BuildRoute(graph::VertexId from, graph::VertexId to) const;
+
+        std::shared_ptr<const Route> BuildRoute(
+                graph::VertexId from,
+                graph::VertexId to,
+                graph::SearchMonitor &monitor
+        ) const;
+
+        // Поиск по графу с весами, пересчитанными под overrides
+        template<typename Monitor>
+        std::shared_ptr<const Route> BuildRoute(
+                graph::VertexId from,
+                graph::VertexId to,
+                const RouteOverrides &overrides,
+                Monitor &monitor
+        ) const;
+
+        std::shared_ptr<const Route> MakeRoute(const RaptorRouter::Journey &journey, double bus_wait_time) const;
+
+        std::shared_ptr<const Route> MakeRoute(
+                const graph::RouteInfo<double> &route_info,
+                double bus_wait_time,
+                double velocity
+        ) const;
+
+        std::vector<geo::Coordinates> GetVertexCoordinates() const;
+
+        double ComputeMinutesPerMeterBound(const TransportCatalogue &transport_catalogue) const;
+
+        std::unique_ptr<FixedPointRouter> CreateFixedPointRouter(
+                const DirectedWeightedGraph<double> &graph,
+                const FixedPointRouter::RouterFactory &create_router
+        ) const;
+
+        void CreateRouter(const TransportCatalogue &transport_catalogue);
     };
 }